@@ -0,0 +1,1524 @@
+//
+// checks of the library against the C library and against itself, run by
+// make check; what fails is printed, and the exit status is the number of
+// failed checks (at most 100)
+//
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <random>
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <unistd.h>
+using namespace std;
+
+#include <stajson.h>
+
+static int failures = 0;
+
+static void fail(int line, const char *what, const string& input) {
+	if (++failures <= 20)
+		cerr << "json-check.cc:" << line << ": failed: " << what << " for " << input.substr(0,200) << endl;
+}
+#define CHECK(x, input) do { if (!(x)) fail(__LINE__, #x, input); } while (0)
+
+static mt19937_64 rng(20240601);  // the same input on every run
+
+static bool same(double a, double b) {  // bit for bit
+	return memcmp(&a, &b, sizeof(double))==0;
+}
+
+static atomic<long> blocks(0);  // from operator new, not yet deleted
+
+// not inlined, or g++ sees the free() of what looks to it like new memory
+__attribute__((noinline)) void *operator new(size_t n) {
+	void *p = malloc(n ? n : 1);
+	if (!p) throw bad_alloc();
+	++blocks;
+	return p;
+}
+__attribute__((noinline)) void operator delete(void *p) noexcept {
+	if (!p) return;
+	--blocks;
+	free(p);
+}
+void operator delete(void *p, size_t) noexcept {
+	operator delete(p);
+}
+
+
+//
+// numbers: the parser is compared with strtod() and the encoder with the
+// shortest of printf("%.*g") that reads back the same
+//
+static double random_double() {
+	for (;;) {
+		uint64_t u = rng();
+		double d;
+		memcpy(&d, &u, sizeof(double));
+		if (isfinite(d)) return d;
+	}
+}
+
+static string random_decimal() {  // digits, fraction and exponent of any length strtod() rounds
+	string s;
+	if (rng()%2) s += '-';
+	int digits = 1 + rng()%25;
+	for (int i = 0 ; i < digits ; ++i)
+		s += (char)('0' + (i==0 && digits>1 ? 1 + rng()%9 : rng()%10));
+	if (rng()%2) {
+		s += '.';
+		for (int i = 1 + rng()%20 ; i ; --i) s += (char)('0' + rng()%10);
+	}
+	if (rng()%2) {
+		char e[16];
+		snprintf(e, sizeof(e), "e%d", (int)(rng()%660) - 340);
+		s += e;
+	}
+	return s;
+}
+
+static void check_parse(const string& s) {
+	for (int how = 0 ; how < 2 ; ++how) {
+		JSON x;
+		try {
+			if (how==0) {
+				json_decode(s, x);
+			} else {
+				istringstream is(s);
+				json_decode(is, x);
+			}
+		} catch (exception& e) {
+			fail(__LINE__, e.what(), s);
+			return;
+		}
+		CHECK(x.type()==JSON_NUMBER, s);
+		if (x.type()!=JSON_NUMBER) return;
+		const JSONNumber& n = x.number();
+		if (n.integer()) {
+			CHECK(s.find_first_of(".eE")==string::npos, s);
+			CHECK(n.int64()==strtoll(s.c_str(), 0, 10), s);
+		} else {
+			CHECK(same(n.value(), strtod(s.c_str(), 0)), s);
+		}
+	}
+}
+
+static void check_format(double d) {
+	char b[32];
+	snprintf(b, sizeof(b), "%.17g", d);
+	string s = json_encode(JSONNumber(d));
+	CHECK(same(strtod(s.c_str(), 0), d), string(b) + " -> " + s);
+	ostringstream os;
+	os << JSONNumber(d);
+	CHECK(os.str()==s, string(b) + " -> " + s);
+
+	int shortest = 17;  // significant digits
+	for (int p = 1 ; p < 17 ; ++p) {
+		snprintf(b, sizeof(b), "%.*g", p, d);
+		if (same(strtod(b, 0), d)) {
+			shortest = p;
+			break;
+		}
+	}
+	string digits;
+	for (size_t i = 0 ; i < s.size() && s[i]!='e' && s[i]!='E' ; ++i)
+		if (s[i]>='0' && s[i]<='9') digits += s[i];
+	digits.erase(0, digits.find_first_not_of('0'));
+	digits.erase(digits.find_last_not_of('0') + 1);
+	CHECK((int)digits.size() <= (shortest > 1 ? shortest : 1), s);
+}
+
+static void check_numbers() {
+	static const char *edges[] = {
+		"0", "-0", "0.0", "-0.0", "1", "-1", "0.1", "1e-7", "5e-324", "4.9406564584124654e-324",
+		"2.4703282292062327e-324", "2.4703282292062328e-324", "2.2250738585072011e-308",
+		"2.2250738585072014e-308", "1.7976931348623157e308", "1.7976931348623158e308",
+		"9007199254740993", "9007199254740993.0", "9223372036854775807", "-9223372036854775808",
+		"9223372036854775808", "-9223372036854775809", "18446744073709551616",
+		"0.30000000000000004", "123456789012345678901234567890", "1e23", "8.98846567431158e307",
+		"1.00000000000000011102230246251565404236316680908203125",
+		"1.00000000000000011102230246251565404236316680908203124",
+		"7.3177701707893310e+15", "2.9802322387695312500e-8", "1e-400", "1e400", "-1e400",
+	};
+	for (size_t i = 0 ; i < sizeof(edges)/sizeof(*edges) ; ++i)
+		check_parse(edges[i]);
+
+	char b[32];
+	for (int i = 0 ; i < 100000 ; ++i) {
+		double d = random_double();
+		snprintf(b, sizeof(b), "%.*g", 1 + (int)(rng()%17), d);
+		check_parse(b);
+		check_parse(random_decimal());
+		check_format(d);
+		check_format((double)(int64_t)(rng() >> (rng()%64)) / 1000);
+	}
+
+	for (int i = 0 ; i < 10000 ; ++i) {  // integers are kept and encoded exactly
+		int64_t v = (int64_t)(rng() >> (rng()%64));
+		if (rng()%2) v = ~v;
+		snprintf(b, sizeof(b), "%lld", (long long)v);
+		CHECK(json_encode(JSONNumber(v))==b, b);
+		JSON x = json_decode(string(b));
+		CHECK(x.number().integer() && x.number().int64()==v, b);
+	}
+
+	// int64() of doubles: truncated, clamped to the range, and 0 for NaN
+	const double doubles[] = { 0.0, -0.0, 2.9, -2.9, 1e18, -9223372036854775808.0, 9223372036854774784.0,
+		9223372036854775808.0, -9223372036854777856.0, 1e300, -1e300, INFINITY, -INFINITY, NAN };
+	const int64_t int64s[] = { 0, 0, 2, -2, 1000000000000000000LL, INT64_MIN, 9223372036854774784LL,
+		INT64_MAX, INT64_MIN, INT64_MAX, INT64_MIN, INT64_MAX, INT64_MIN, 0 };
+	for (size_t i = 0 ; i < sizeof(doubles)/sizeof(*doubles) ; ++i) {
+		snprintf(b, sizeof(b), "%.17g", doubles[i]);
+		CHECK(JSONNumber(doubles[i]).int64()==int64s[i], b);
+	}
+}
+
+static const char *documents[] = {
+	"null", "true", "false", "0", "-12.5e3", "123456789012345678901", "\"\"",
+	"\"a \\\"quoted\\\" \\\\ string\\n\\u00e9\\ud83d\\ude00 and some more\"",
+	"[]", "{}", "[1,[2,[3,[]]],{\"a\":{\"b\":[true,null]}}]",
+	"{\"key\":\"value\",\"n\":-0.5,\"list\":[\"x\",1e-3,{}],\"\":\"\"}",
+	"[ 1 ,\n\t2 ] ",
+};
+
+static const char *broken[] = {
+	"[1,2", "{\"a\" 1}", "[1,]", "\"unterminated", "tru", "[1 2]", "{\"a\":1,}",
+	"\"bad \\x escape\"", "{\"a\":\"bad \\x escape\"}", "[1,\"\\uzz\"]",
+	"{\"a\":-}", "[1.e5]", "}", "nul", "\"\\u12\"", "[\"\\u004x\"]",
+};
+
+static string random_value(int depth) {
+	static const char *atoms[] = { "null", "true", "false", "0", "-1", "12.5e3", "123456789012345",
+		"\"\"", "\"a\\\"b\\\\\"", "\"x\\u0041y\"", "\"a string with , and ] and } inside\"" };
+	int r = rng()%10;
+	if (depth > 4 || r < 4) return atoms[rng() % (sizeof(atoms)/sizeof(*atoms))];
+	string s = r < 7 ? "[" : "{";
+	for (int i = rng()%6 ; i ; --i) {
+		if (s.size() > 1) s += ',';
+		if (r >= 7) s += "\"k" + to_string(rng()%9) + "\":";
+		s += random_value(depth+1);
+	}
+	return s + (r < 7 ? "]" : "}");
+}
+
+
+//
+// values: null, booleans and numbers are made, copied and assigned without
+// allocating, and what is decoded encodes to what decodes the same again
+//
+static void check_values() {
+	CHECK(sizeof(JSON)==sizeof(JSONNumber), to_string(sizeof(JSON)));
+
+	vector<JSON> v(8);
+	long before = blocks;
+	{
+		JSON n, t(true), f = false, d(2.5);
+		JSON c(d), e;
+		e = t;
+		e = n;
+		e = -1.0;
+		c = e;
+		v[0] = t;
+		v[1] = f;
+		v[2] = d;
+		v[3] = c;
+		CHECK(n.type()==JSON_NULL && t==true && f==false && d==2.5 && c==-1.0 && e==-1.0, "scalars");
+		CHECK(t.boolean().value() && d.number().value()==2.5 && v[2]==2.5 && v[3]==-1.0, "scalars");
+	}
+	CHECK(blocks==before, "scalars: " + to_string(blocks-before) + " blocks");
+
+	{
+		JSON s("a string"), a = JSONArray(), o = JSONObject();
+		CHECK(blocks > before, "a string");
+		s = 1.0;
+		a = true;
+		o = JSON();
+		CHECK(s==1.0 && a==true && o.type()==JSON_NULL, "a string");
+		CHECK(blocks==before, "a string replaced: " + to_string(blocks-before) + " blocks");
+		v[4] = "another";
+		v[4] = false;
+		CHECK(blocks==before, "a member replaced: " + to_string(blocks-before) + " blocks");
+		a = JSONArray(3, JSON(true));
+		a = a.array()[1];  // by a member of itself
+		o = JSONObject();
+		o.object()["k"] = 2.0;
+		o = o.object()["k"];
+		CHECK(a==true && o==2.0 && blocks==before, "a value replaced by a member");
+	}
+
+	vector<string> in(documents, documents + sizeof(documents)/sizeof(*documents));
+	for (int i = 0 ; i < 200 ; ++i)
+		in.push_back(random_value(0));
+	for (size_t d = 0 ; d < in.size() ; ++d) {
+		before = blocks;
+		{
+			JSON x = json_decode(in[d]);
+			string s = json_encode(x);
+			JSON y = json_decode(s);
+			CHECK(y==x && json_encode(y)==s, in[d] + " -> " + s);
+			y = x;
+			CHECK(y==x, in[d]);
+		}
+		CHECK(blocks==before, in[d] + ": " + to_string(blocks-before) + " blocks left");
+	}
+
+	for (size_t b = 0 ; b < sizeof(broken)/sizeof(*broken) ; ++b) {
+		bool thrown = false;
+		try {
+			json_decode(string(broken[b]));
+		} catch (runtime_error&) {
+			thrown = true;
+		}
+		CHECK(thrown, broken[b]);
+	}
+
+	// arrays and objects nested json_max_depth deep decode, and one level
+	// deeper is an error, from strings and streams; a document that fails
+	// half-way leaves nothing allocated
+	for (size_t depth = json_max_depth ; depth <= json_max_depth+1 ; ++depth) {
+		string open, close;
+		for (size_t i = 0 ; i < depth ; ++i) {
+			open += i%2 ? "{\"k\":" : "[";
+			close.insert(0, i%2 ? "}" : "]");
+		}
+		for (int how = 0 ; how < 4 ; ++how) {
+			const string s = open + "0" + (how < 2 ? close : close.substr(1));
+			bool thrown = false, deep = false;
+			before = blocks;
+			try {
+				JSON x;
+				if (how%2==0) {
+					json_decode(s, x);
+				} else {
+					istringstream is(s);
+					json_decode(is, x);
+				}
+			} catch (runtime_error& e) {
+				thrown = true;
+				deep = strstr(e.what(), "too deep")!=0;
+			}
+			CHECK(depth > json_max_depth ? deep : thrown==(how >= 2), s);
+			CHECK(blocks==before, s + ": " + to_string(blocks-before) + " blocks left");
+		}
+	}
+}
+
+//
+// strings: quotes, brackets and runs of backslashes inside strings, at every
+// offset of the 64-byte blocks the decoder indexes, and runs of plain
+// characters longer than any buffer they are copied through, decode from
+// strings and streams to what was encoded; and every byte encodes the same
+// to strings and streams
+//
+static void check_strings() {
+	for (size_t pad = 0 ; pad < 1100 ; pad += pad < 70 ? 1 : 257) {
+		for (size_t run = 0 ; run < 4 ; ++run) {
+			const string v = string(pad, 'x') + string(run, '\\') + "\"{[,:]}\" \\u" + string(pad, 'y');
+			const string e = json_encode(JSON(v));
+			const string s = string(pad%5, ' ') + "[" + e + "," + e + ",-1]";
+			for (int how = 0 ; how < 2 ; ++how) {
+				JSON x;
+				if (how==0) {
+					x = json_decode(s);
+				} else {
+					istringstream is(s);
+					json_decode(is, x);
+				}
+				CHECK(x.array().size()==3 && x[0].string().value()==v && x[1].string().value()==v && x[2]==-1.0, s);
+			}
+		}
+	}
+
+	// every byte but NUL at every offset of the encoders' 16-byte runs:
+	// control characters are escaped as \u00XX, bytes from 0x80 are copied
+	// as they are, and strings and streams get the same characters
+	string all;
+	for (int c = 1 ; c < 256 ; ++c)
+		all.push_back((char)c);
+	for (size_t pad = 0 ; pad < 40 ; ++pad) {
+		const JSON x(string(pad, 'x') + all);
+		const string e = json_encode(x);
+		ostringstream os;
+		os << x;
+		CHECK(os.str()==e, e);
+		CHECK(e.find("\\u001f")!=string::npos && e.find("\x80\x81")!=string::npos, e);
+		CHECK(json_decode(e)==x, e);
+	}
+}
+
+//
+// moves: a JSON, string, array or object moved into place allocates nothing
+// and leaves null or empty behind, and growing an array of them moves them
+//
+static void check_moves() {
+	const JSON x = json_decode(string("[\"a string long enough to be allocated\",[1,2,3],{\"k\":\"v\"}]"));
+	JSON a = x;
+	long before = blocks;
+	JSON b(std::move(a));
+	CHECK(blocks==before && a.type()==JSON_NULL && b==x, "moved");
+	a = std::move(b);
+	CHECK(blocks==before && b.type()==JSON_NULL && a==x, "moved back");
+	a = std::move(a);
+	CHECK(a==x, "moved to itself");
+	a = std::move(a[1]);  // a member of the value it replaces
+	CHECK(a==json_decode(string("[1,2,3]")), "moved from a member");
+
+	JSONArray v;
+	for (int i = 0 ; i < 100 ; ++i)
+		v.push_back(x);
+	const JSONBase *first = v[0].get(), *last = v[99].get();
+	before = blocks;
+	v.reserve(1000);  // a new buffer for the old one, and the elements moved into it
+	CHECK(blocks==before && v[0].get()==first && v[99].get()==last && v[99]==x, "reserve: " + to_string(blocks-before) + " blocks");
+
+	string s(100, 'x');
+	JSONArray l;
+	before = blocks;
+	JSON t(std::move(s));  // the node only, the characters are the string's
+	CHECK(blocks==before+1 && t==string(100, 'x'), "a string moved in");
+	l.push_back(JSON());
+	l.emplace_back(2.0);
+	before = blocks;
+	l[0] = std::move(t);
+	JSONObject o;
+	o["k"] = std::move(l);
+	CHECK(o["k"].array().size()==2 && o["k"][1]==2.0 && o["k"][0].string().value().size()==100, "moved into an object");
+	CHECK(blocks==before+2, "moved into an object: " + to_string(blocks-before) + " blocks");
+}
+
+//
+// sharing: after JSON::share(), copies share nodes, and a modification of
+// either side copies the nodes on its way, so the other side does not see it
+//
+static void check_sharing() {
+	const string in = "{\"s\":\"text\",\"a\":[1,[2,3],{\"k\":\"v\"}],\"o\":{\"x\":null}}";
+	JSON a = json_decode(in);
+	const JSON original = json_decode(in);
+	a.share();
+	JSON b = a, c = b;
+	const JSON& ca = a;
+	const JSON& cb = b;
+	CHECK(&ca["a"].array()==&cb["a"].array(), in);
+	CHECK(&ca["s"].string()==&cb["s"].string(), in);
+
+	b["a"][1][0] = 9;
+	b["o"]["y"] = true;
+	b["s"] = "other";
+	CHECK(a==original && c==original, in);
+	CHECK(b==json_decode(string("{\"s\":\"other\",\"a\":[1,[9,3],{\"k\":\"v\"}],\"o\":{\"x\":null,\"y\":true}}")), in);
+	CHECK(&ca["a"][2].object()==&cb["a"][2].object(), in);  // not on the way, still shared
+
+	JSON d = ca["a"][2];  // a copy of a member is shared too
+	d["k"] = "w";
+	CHECK(a==original, in);
+	a["a"].array().push_back(4);  // and so is the original
+	CHECK(b["a"].array().size()==3 && c==original, in);
+
+	a = JSON();
+	c = JSON();
+	CHECK(b["o"]["x"].type()==JSON_NULL && d["k"].string().value()=="w", in);
+	JSON e = b;  // copies of a modified value are not shared, but are copies still
+	e["a"][0] = 0;
+	CHECK(b["a"][0].number().int64()==1, in);
+
+	// a reference handed out before a copy is made changes only the original
+	a = json_decode(in);
+	a.share();
+	JSON& x = a["a"];
+	JSON f = a;
+	x[0] = 100;
+	x[1][0] = 200;
+	CHECK(f==original && a["a"][0].number().int64()==100 && a["a"][1][0].number().int64()==200, in);
+	JSONArray& r = a["a"][1].array();
+	const JSON g = a;
+	r.push_back(300);
+	CHECK(g["a"][1].array().size()==2 && a["a"][1].array().size()==3, in);
+
+	a.share();  // until the value is shared again
+	const JSON h = a;
+	CHECK(&h["a"].array()==&static_cast<const JSON&>(a)["a"].array(), in);
+}
+
+
+//
+// objects: random insertions and erasures, back and forth across SMALL
+// members, against a list of the members in insertion order; the default
+// JSONObject iterates in key order, and the ordered one in that of the list
+//
+typedef vector<pair<string,int64_t> > members;
+
+static string describe(const members& m) {
+	string s;
+	for (size_t i = 0 ; i < m.size() ; ++i)
+		s += m[i].first + "=" + to_string(m[i].second) + " ";
+	return s;
+}
+
+static void check_members(const JSONObject& o, const members& model) {
+	members order(model);
+#ifndef STAJSON_ORDERED_OBJECTS
+	sort(order.begin(), order.end());
+#endif
+	members seen;
+	for (JSONObject::const_iterator i = o.begin() ; i!=o.end() ; ++i)
+		seen.push_back(make_pair(i->first, i->second.number().int64()));
+	CHECK(o.size()==order.size() && seen==order, describe(seen) + "instead of " + describe(order));
+
+	for (size_t i = 0 ; i < order.size() ; ++i) {
+		JSONObject::const_iterator f = o.find(order[i].first);
+		CHECK(f!=o.end() && f->second.number().int64()==order[i].second, order[i].first);
+	}
+}
+
+static void fill(JSONObject& o, members& model, size_t n, const char **keys) {
+	o.clear();
+	model.clear();
+	for (size_t i = 0 ; i < n ; ++i) {
+		o[keys[i]] = (int64_t)i;
+		model.push_back(make_pair(string(keys[i]), (int64_t)i));
+	}
+}
+
+static void check_objects() {
+	static const char *keys[] = { "a", "b", "c", "d", "e", "f", "g", "h", "i", "j", "k", "l",
+		"", "aa", "ab", "a long key that is not like the others, to be sure" };
+	const size_t n = sizeof(keys)/sizeof(*keys);
+	JSONObject o;
+	members model;
+	for (int round = 0 ; round < 20000 ; ++round) {
+		// grow up to all the keys, then shrink down to none; every other time
+		// from a new object, with only as many keys as stay in the flat array
+		if (round%400==0) {
+			o.clear();
+			model.clear();
+		}
+		bool grow = round/200 % 2==0;
+		string k = keys[rng() % (round/400 % 2 ? (size_t)JSONSmallMap::SMALL : n)];
+		members::iterator m = model.begin();
+		while (m!=model.end() && m->first!=k) ++m;
+		switch (rng()%8) {
+		case 0: case 1: case 2:
+			if (!grow) goto erase;
+			o[k] = (int64_t)round;
+			if (m!=model.end()) m->second = round;
+			else model.push_back(make_pair(k, (int64_t)round));
+			break;
+		case 3: {
+			bool added = rng()%2 ? o.insert(JSONObject::value_type(k, JSON((int64_t)round))).second
+				: o.insert(make_pair(string(k), JSON((int64_t)round))).second;  // a key that can be moved
+			CHECK(added==(m==model.end()), k);
+			if (added) model.push_back(make_pair(k, (int64_t)round));
+			break;
+			}
+		case 4: case 5: case 6:
+			if (grow) break;
+		erase:
+			CHECK(o.erase(k)==(m!=model.end() ? 1u : 0u), k);
+			if (m!=model.end()) model.erase(m);
+			break;
+		default: {
+			JSONObject c(o);  // a copy is equal, until it is changed
+			CHECK(c.operator==(o), describe(model));  // c==o is ambiguous between the member and the free function
+			c[k] = -1;
+			CHECK(!c.operator==(o), describe(model));
+			o.swap(c);
+			o.swap(c);
+			}
+		}
+		check_members(o, model);
+	}
+
+	// erasing ranges, with the members in the tree and in the flat array; the
+	// ordered JSONObject has none, so every other member is erased while iterating
+	for (size_t size = n ; size ; size = size > JSONSmallMap::SMALL ? JSONSmallMap::SMALL : 0) {
+		fill(o, model, size, keys);
+#ifdef STAJSON_ORDERED_OBJECTS
+		for (JSONObject::iterator i = o.begin() ; i!=o.end() ; )
+			if (i->second.number().int64()%2) o.erase(i++);
+			else ++i;
+		for (size_t i = model.size() ; i-- ; )
+			if (model[i].second%2) model.erase(model.begin()+i);
+		check_members(o, model);
+		o["b"] = 100;  // erased members stay erased when others are added after them
+		model.push_back(make_pair(string("b"), (int64_t)100));
+#else
+		o.erase(o.lower_bound("b"), o.upper_bound("f"));
+		for (size_t i = model.size() ; i-- ; )
+			if (model[i].first>="b" && model[i].first<="f") model.erase(model.begin()+i);
+		check_members(o, model);
+		o.erase(o.begin());
+		model.erase(min_element(model.begin(), model.end()));
+		o.erase(o.lower_bound("g"), o.end());
+		for (size_t i = model.size() ; i-- ; )
+			if (model[i].first>="g") model.erase(model.begin()+i);
+#endif
+		check_members(o, model);
+	}
+
+	// erasing every member while iterating, as is done with std::map
+	for (size_t size = n ; size ; size = size > JSONSmallMap::SMALL ? JSONSmallMap::SMALL : 0) {
+		fill(o, model, size, keys);
+		for (JSONObject::iterator i = o.begin() ; i!=o.end() ; )
+			o.erase(i++);
+		CHECK(o.empty(), describe(model));
+	}
+
+#ifndef STAJSON_ORDERED_OBJECTS
+	// references to members stay valid while others are added and erased,
+	// as long as the members stay in the flat array
+	fill(o, model, 1, keys+1);
+	JSON& b = o["b"];
+	o["a"] = 2;
+	b = 99;
+	CHECK(o["a"]==2.0 && o["b"]==99.0, json_encode(o));
+	for (size_t i = 2 ; i < JSONSmallMap::SMALL ; ++i)
+		o[keys[i]] = (int64_t)i;
+	o.erase("a");
+	o.erase("h");
+	b = 100;
+	CHECK(o.size()==JSONSmallMap::SMALL-2 && o["b"]==100.0 && &o["b"]==&b, json_encode(o));
+#endif
+
+	// keys decoded one after another into the same buffer, with and without
+	// escapes, and longer and shorter than the one before
+	const string in = "{\"a key long enough to need a heap buffer\":1,\"k\":2,\"\\u0041\\\"b\":3,"
+		"\"\":4,\"another key long enough to need a heap buffer\":{\"k\":5,\"a\\nb\":6}}";
+	for (int how = 0 ; how < 2 ; ++how) {
+		JSON x;
+		if (how==0) {
+			json_decode(in, x);
+		} else {
+			istringstream is(in);
+			json_decode(is, x);
+		}
+		const JSON& c = x;
+		CHECK(c.object().size()==5 && c["a key long enough to need a heap buffer"]==1.0 && c["k"]==2.0
+			&& c["A\"b"]==3.0 && c[""]==4.0, in);
+		const JSON& y = c["another key long enough to need a heap buffer"];
+		CHECK(y.object().size()==2 && y["k"]==5.0 && y["a\nb"]==6.0, in);
+	}
+}
+
+
+//
+// json_parse(): a handler that builds the value again from the calls gets
+// what json_decode() gets, from strings and streams, and the same errors
+//
+struct rebuild {
+	vector<JSON> open;  // arrays and objects not yet ended
+	vector<std::string> keys;  // what each of them goes under in the one before
+	std::string name;  // of the next member
+	JSON root;
+
+	void put(const JSON& x) {
+		if (open.empty())
+			root = x;
+		else if (open.back().type()==JSON_ARRAY)
+			open.back().array().push_back(x);
+		else
+			open.back().object()[name] = x;
+	}
+	void end() {
+		JSON x = std::move(open.back());
+		open.pop_back();
+		name = keys.back();
+		keys.pop_back();
+		put(x);
+	}
+
+	void null() { put(JSON()); }
+	void boolean(bool v) { put(JSON(v)); }
+	void number(const JSONNumber& v) { put(v.integer() ? JSON(v.int64()) : JSON(v.value())); }
+	void string(const char *s, size_t n) { put(JSON(std::string(s, n))); }
+	void key(const char *s, size_t n) { name.assign(s, n); }
+	void start_array() { keys.push_back(name); open.push_back(JSONArray()); }
+	void start_object() { keys.push_back(name); open.push_back(JSONObject()); }
+	void end_array() { end(); }
+	void end_object() { end(); }
+};
+
+static void check_handlers() {
+	vector<string> in(documents, documents + sizeof(documents)/sizeof(*documents));
+	for (int i = 0 ; i < 200 ; ++i)
+		in.push_back(random_value(0));
+	in.insert(in.end(), broken, broken + sizeof(broken)/sizeof(*broken));
+	for (size_t d = 0 ; d < in.size() ; ++d) {
+		JSON x;
+		string expected;
+		try {
+			json_decode(in[d], x);
+		} catch (runtime_error& e) {
+			expected = e.what();
+		}
+		for (int how = 0 ; how < 2 ; ++how) {
+			rebuild h;
+			string error;
+			try {
+				if (how==0) {
+					json_parse(in[d], h);
+				} else {
+					istringstream is(in[d]);
+					json_parse(is, h);
+				}
+			} catch (runtime_error& e) {
+				error = e.what();
+			}
+			CHECK(error==expected && (!error.empty() || h.root==x), in[d] + ": " + error);
+		}
+	}
+}
+
+
+//
+// JSONReader: random documents are built again from its tokens, taking
+// some arrays and objects whole with value(), and walked again skipping
+// some with skip(), against json_decode() and a walk without skipping
+//
+static JSON reread(JSONReader& r) {  // the value at the current token
+	switch (r.token()) {
+	case JSONReader::NULL_VALUE: return JSON();
+	case JSONReader::BOOLEAN: return r.boolean();
+	case JSONReader::NUMBER: return r.number().integer() ? JSON(r.number().int64()) : JSON(r.number().value());
+	case JSONReader::STRING: return r.string();
+	case JSONReader::ARRAY_START: case JSONReader::OBJECT_START:
+		if (rng()%4==0) return r.value();
+		break;
+	default:
+		throw logic_error("not at a value");
+	}
+	if (r.token()==JSONReader::ARRAY_START) {
+		JSON x = JSONArray();
+		while (r.next()!=JSONReader::ARRAY_END)
+			x.array().push_back(reread(r));
+		return x;
+	}
+	JSON x = JSONObject();
+	while (r.next()!=JSONReader::OBJECT_END) {
+		string k = r.string();
+		if (rng()%4==0) {
+			x[k] = r.value();  // from the key
+		} else {
+			r.next();
+			x[k] = reread(r);
+		}
+	}
+	return x;
+}
+
+static string read_error(const string& in) {  // what walking all of @in with next() throws
+	try {
+		JSONReader r(in);
+		while (r.next()!=JSONReader::END) { }
+	} catch (exception& e) {
+		return e.what();
+	}
+	return "";
+}
+
+static string decode_error(const string& in) {
+	try {
+		json_decode(in);
+	} catch (exception& e) {
+		return e.what();
+	}
+	return "";
+}
+
+static void check_reader() {
+	vector<string> in(documents, documents + sizeof(documents)/sizeof(*documents));
+	for (int i = 0 ; i < 2000 ; ++i)
+		in.push_back(random_value(0));
+
+	for (size_t d = 0 ; d < in.size() ; ++d) {
+		const string& s = in[d];
+		JSONReader r(s);
+		CHECK(r.token()==JSONReader::END && r.next()!=JSONReader::END, s);
+		JSON x = reread(r);
+		CHECK(x==json_decode(s) && r.next()==JSONReader::END && r.depth()==0, s);
+
+		vector<pair<JSONReader::Token,size_t> > all;  // every token, and where it is
+		JSONReader w(s);
+		while (w.next()!=JSONReader::END)
+			all.push_back(make_pair(w.token(), w.offset()));
+		JSONReader k(s);
+		for (size_t i = 0 ; i < all.size() ; ++i) {
+			CHECK(k.next()==all[i].first && k.offset()==all[i].second, s + " at token " + to_string(i));
+			if ((all[i].first==JSONReader::ARRAY_START || all[i].first==JSONReader::OBJECT_START) && rng()%3==0) {
+				size_t depth = k.depth();
+				for (int open = 1 ; open ; ) {  // to the end of the same array or object
+					JSONReader::Token t = all[++i].first;
+					open += t==JSONReader::ARRAY_START || t==JSONReader::OBJECT_START;
+					open -= t==JSONReader::ARRAY_END || t==JSONReader::OBJECT_END;
+				}
+				k.skip();
+				CHECK(k.token()==all[i].first && k.offset()==all[i].second && k.depth()==depth-1, s + " skipped to token " + to_string(i));
+			}
+		}
+		CHECK(k.next()==JSONReader::END, s);
+
+		// cut short, the reader fails where json_decode() does
+		string cut = s.substr(0, rng() % s.size());
+		CHECK(read_error(cut)==decode_error(cut), cut + ": " + read_error(cut) + " instead of " + decode_error(cut));
+	}
+
+	for (size_t b = 0 ; b < sizeof(broken)/sizeof(*broken) ; ++b) {
+		string e = read_error(broken[b]);
+		CHECK(!e.empty() && e==decode_error(broken[b]), broken[b] + (": " + e));
+	}
+}
+
+
+//
+// JSONPushParser: the same input is fed cut at every point, and in random
+// pieces, and must give the values json_decode() gives, or its error
+//
+static vector<JSON> push(const string& in, vector<size_t> cuts, string& error) {
+	// the values of @in fed in pieces that end at @cuts; @error is set to what is thrown
+	JSONPushParser p;
+	vector<JSON> out;
+	JSON x;
+	sort(cuts.begin(), cuts.end());
+	cuts.push_back(in.size());
+	error.clear();
+	try {
+		for (size_t i = 0, from = 0 ; i < cuts.size() ; from = cuts[i++]) {
+			p.feed(in.data()+from, cuts[i]-from);
+			while (p.next(x)) out.push_back(x);
+		}
+		p.finish();
+	} catch (exception& e) {
+		error = e.what();
+	}
+	while (p.next(x)) out.push_back(x);
+	return out;
+}
+
+static void check_push() {
+	const size_t n = sizeof(documents)/sizeof(*documents);
+	string all, error;
+	vector<JSON> expected;
+	for (size_t d = 0 ; d < n ; ++d) {
+		JSON x = json_decode(string(documents[d]));
+		for (size_t i = 0 ; i <= strlen(documents[d]) ; ++i) {
+			vector<JSON> out = push(documents[d], vector<size_t>(1, i), error);
+			CHECK(error.empty() && out.size()==1 && out[0]==x, documents[d] + (" cut at " + to_string(i)));
+		}
+		all += documents[d];
+		all += d%2 ? "\n" : " ";
+		expected.push_back(x);
+	}
+
+	for (size_t i = 0 ; i <= all.size() ; ++i) {
+		vector<JSON> out = push(all, vector<size_t>(1, i), error);
+		CHECK(error.empty() && out==expected, "the documents cut at " + to_string(i));
+	}
+	for (int round = 0 ; round < 2000 ; ++round) {
+		vector<size_t> cuts(1 + rng()%40);
+		for (size_t i = 0 ; i < cuts.size() ; ++i) cuts[i] = rng() % (all.size()+1);
+		vector<JSON> out = push(all, cuts, error);
+		CHECK(error.empty() && out==expected, "the documents cut in round " + to_string(round));
+	}
+
+	for (size_t b = 0 ; b < sizeof(broken)/sizeof(*broken) ; ++b) {
+		// the values before an error are given, and the error is where json_decode() finds it
+		string decoded;
+		try {
+			json_decode(string(broken[b]));
+		} catch (exception& e) {
+			decoded = e.what();
+		}
+		CHECK(!decoded.empty(), broken[b]);
+		string in = string("[0] ") + broken[b];
+		for (size_t i = 0 ; i <= in.size() ; ++i) {
+			vector<JSON> out = push(in, vector<size_t>(1, i), error);
+			CHECK(out.size()==1 && out[0]==json_decode(string("[0]")), in + " cut at " + to_string(i));
+			CHECK(error==decoded, in + " cut at " + to_string(i) + ": " + error + " instead of " + decoded);
+		}
+	}
+}
+
+
+//
+// json_decode(std::istream&): one value after another, from a string stream
+// and from a file read through buffers of several sizes, against each value
+// decoded on its own; a value ends where the stream is left, and only a
+// number at the end of the input has to read to the end of the file
+//
+struct stream_input {
+	string s;
+	vector<pair<size_t,size_t> > at;  // where each value starts and ends in @s
+
+	void add(const string& before, const string& value) {  // @value may have whitespace around it
+		s += before;
+		at.push_back(make_pair(s.size() + value.find_first_not_of(" \t\r\n"), s.size() + value.find_last_not_of(" \t\r\n") + 1));
+		s += value;
+	}
+};
+
+static string temp_file(const string& contents) {
+	char path[] = "/tmp/json-check-XXXXXX";
+	int fd = mkstemp(path);
+	if (fd < 0) throw runtime_error("no temporary file");
+	bool written = write(fd, contents.data(), contents.size())==(ssize_t)contents.size();
+	close(fd);
+	if (!written) throw runtime_error("temporary file not written");
+	return path;
+}
+
+static void read_stream(istream& in, const stream_input& input, const string& how) {
+	const string& s = input.s;
+	for (size_t v = 0 ;; ++v) {
+		JSON x;
+		string error;
+		try {
+			json_decode(in, x);
+		} catch (runtime_error& e) {
+			error = e.what();
+		}
+		if (v==input.at.size()) {
+			CHECK(error=="JSON no token" && in.eof() && in.fail(), how + ": " + error + " after the last value");
+			return;
+		}
+		size_t start = input.at[v].first, p = input.at[v].second;
+		JSON y = json_decode(s.substr(start, p-start));
+		CHECK(error.empty() && x==y, how + ": " + error + " at " + to_string(start));
+		if (!error.empty()) return;
+		if (p==s.size() && y.type()==JSON_NUMBER) {
+			CHECK(in.eof() && in.fail(), how + ": the number at the end");
+		} else {
+			CHECK(in.good() && in.tellg()==(streamoff)p, how + ": left at " + to_string(in.tellg()) + " instead of " + to_string(p));
+			if (!in.good()) return;
+		}
+	}
+}
+
+static void check_streams() {
+	vector<stream_input> inputs(8);
+	inputs[0].add("", "1");
+	inputs[0].add(" ", "2");
+	inputs[1].add("", "{}");
+	inputs[1].add("", "{}");
+	inputs[2] = inputs[1];
+	inputs[2].s += " ";
+	const char *values[] = { "[1]", "\"s\"", "true", "[1]", "null", "{}", " -0.5e3" };
+	for (size_t i = 0 ; i < sizeof(values)/sizeof(*values) ; ++i)
+		inputs[3].add("", values[i]);
+	inputs[3].s += "\n";
+	inputs[4].add("", "12.5");
+	inputs[5].s = " \n";
+
+	const size_t n = sizeof(documents)/sizeof(*documents);
+	string big = "[";
+	for (size_t d = 0 ; d < n ; ++d)  // whitespace where a literal or number needs it, and some more
+		inputs[6].add(d%3==2 || (d && !strchr("]}\"", inputs[6].s[inputs[6].s.size()-1])) ? (d%3==2 ? "\n" : " ") : "", documents[d]);
+	while (big.size() < 200000) big += documents[rng()%n] + string(",");
+	big += "\"" + string(70000, 'x') + "\"]";
+	inputs[7].add("", big);  // values across many refills of any buffer
+	for (size_t i = 0 ; i < inputs[6].at.size() ; ++i)
+		inputs[7].add(i%3==2 ? "\n" : " ", inputs[6].s.substr(inputs[6].at[i].first, inputs[6].at[i].second-inputs[6].at[i].first));
+	inputs[7].add(" ", big);
+
+	for (size_t i = 0 ; i < inputs.size() ; ++i) {
+		const string& s = inputs[i].s;
+		string name = i < 6 ? "'" + s + "'" : "input " + to_string(i);
+		istringstream is(s);
+		read_stream(is, inputs[i], name + " from a string stream");
+
+		string path = temp_file(s);
+		const size_t sizes[] = { 0, 1, 7, 4096, 0 };  // 0 first: unbuffered; 0 last: the default
+		for (size_t b = 0 ; b < sizeof(sizes)/sizeof(*sizes) ; ++b) {
+			vector<char> buf(sizes[b]);
+			ifstream f;
+			if (b+1 < sizeof(sizes)/sizeof(*sizes))
+				f.rdbuf()->pubsetbuf(buf.data(), buf.size());
+			f.open(path.c_str(), ios::binary);
+			read_stream(f, inputs[i], name + " from a file with a buffer of " + to_string(sizes[b]));
+		}
+		unlink(path.c_str());
+	}
+
+	// what follows a value is left in the stream
+	istringstream is("[1]x");
+	JSON x;
+	json_decode(is, x);
+	CHECK(x==json_decode("[1]") && is.get()=='x' && is.get()==EOF, "[1]x");
+}
+
+
+//
+// JSONDocument: trees in an arena, with strings and keys too long to fit
+// inside a std::string, decoded from strings and streams, and borrowing
+// from the input, against json_decode(); values copied out outlive the
+// document and its input, and a document holds no memory once it is
+// cleared, or has failed to decode
+//
+static string long_strings(int members) {
+	string s = "{";
+	for (int i = 0 ; i < members ; ++i) {
+		if (i) s += ',';
+		s += "\"a key too long to fit inside a std::string " + to_string(i) + "\":[\"a value too long to fit inside one either\","
+			"\"one with an \\\"escape\\\", and long enough as well\",\"short\",\"\\u00e9\"," + random_value(1) + "]";
+	}
+	return s + "}";
+}
+
+static size_t borrowed(const JSON& x, const string& in) {  // strings that refer to @in; @in must hold the input
+	size_t n = 0;
+	if (x.type()==JSON_STRING && x.string().borrowed()) {
+		const JSONString& s = x.string();
+		CHECK(s.data() >= in.data() && s.data()+s.size() <= in.data()+in.size() && s.data()[-1]=='"', in);
+		++n;
+	} else if (x.type()==JSON_ARRAY) {
+		for (size_t i = 0 ; i < x.array().size() ; ++i)
+			n += borrowed(x[i], in);
+	} else if (x.type()==JSON_OBJECT) {
+		for (JSONObject::const_iterator i = x.object().begin() ; i!=x.object().end() ; ++i)
+			n += borrowed(i->second, in);
+	}
+	return n;
+}
+
+static void check_documents() {
+	vector<string> in(documents, documents + sizeof(documents)/sizeof(*documents));
+	in.push_back(long_strings(3));
+	in.push_back(long_strings(300));
+	for (int i = 0 ; i < 200 ; ++i)
+		in.push_back(random_value(0));
+
+	for (size_t d = 0 ; d < in.size() ; ++d) {
+		const string& s = in[d];
+		const JSON x = json_decode(s);
+		for (int how = 0 ; how < 3 ; ++how) {
+			long before = blocks;
+			JSON copy;
+			{
+				string input(s);  // goes away before the copy is used
+				JSONDocument doc;
+				if (how==0) {
+					json_decode(input, doc);
+				} else if (how==1) {
+					istringstream is(input);
+					json_decode(is, doc);
+				} else {
+					json_decode_borrowed(input, doc);
+					size_t n = borrowed(doc.root(), input);
+					CHECK(n>0 || s.find("\"short\"")==string::npos, s);  // the strings of long_strings() without escapes
+				}
+				CHECK(doc.root()==x, s);
+				copy = doc.root();
+				doc.clear();
+				CHECK(doc.type()==JSON_NULL, s);
+				json_decode(long_strings(2), doc);  // into the same arena, after clear()
+				input.assign(input.size(), 'x');
+			}
+			CHECK(copy==x, s + " copied out, by way " + to_string(how));
+			copy = JSON();
+			CHECK(blocks==before, s + " decoded by way " + to_string(how) + ": " + to_string(blocks-before) + " blocks left");
+		}
+	}
+
+	// errors after most of the tree is built, in a document that had one before
+	string bad = long_strings(300);
+	bad.insert(bad.size()-1, ",");
+	JSONDocument doc;
+	long before = blocks;
+	for (int how = 0 ; how < 3 ; ++how) {
+		json_decode(long_strings(300), doc);
+		CHECK(blocks > before, "long strings");
+		bool thrown = false;
+		try {
+			if (how==0) {
+				json_decode(bad, doc);
+			} else if (how==1) {
+				istringstream is(bad);
+				json_decode(is, doc);
+			} else {
+				json_decode_borrowed(bad, doc);
+			}
+		} catch (runtime_error&) {
+			thrown = true;
+		}
+		CHECK(thrown && doc.type()==JSON_NULL && blocks==before, "failed decode by way " + to_string(how) + ": " + to_string(blocks-before) + " blocks left");
+	}
+}
+
+
+//
+// JSONParallelDecoder: a series of values over a few chunks, some on one
+// line, some across lines and some with nothing between them, and lines
+// with errors, against json_decode(std::istream&) from one value to the
+// next, going on at the next line after an error
+//
+static void serial(const string& in, vector<JSON>& out, vector<bool>& failed) {
+	istringstream is(in);
+	for (size_t p = 0 ; (p = in.find_first_not_of(" \t\r\n", p))!=string::npos ;) {
+		JSON x;
+		is.clear();
+		is.seekg(p);
+		try {
+			json_decode(is, x);
+			p = is.good() ? (size_t)is.tellg() : in.size();  // a number at the end reads to the end
+			failed.push_back(false);
+		} catch (runtime_error&) {
+			failed.push_back(true);
+			size_t nl = in.find('\n', p);
+			p = nl==string::npos ? in.size() : nl+1;
+		}
+		out.push_back(x);
+	}
+}
+
+static void check_batch() {
+	string in;
+	while (in.size() < (7<<19)) {
+		switch (rng()%8) {
+		case 0: {  // an array across lines
+			in += "[\n";
+			for (int i = rng()%200 ; i ; --i)
+				in += random_value(2) + ",\n";
+			in += "0\n]";
+			} break;
+		case 1:  // values with nothing between them
+			in += "{}[]" + random_value(1) + "[1]\"s\"{\"a\":{}}";
+			break;
+		case 2:
+			in += broken[rng() % (sizeof(broken)/sizeof(*broken))];
+			break;
+		default:
+			in += random_value(0);
+		}
+		in += rng()%4 ? "\n" : " ";
+	}
+
+	vector<JSON> expected;
+	vector<bool> failed;
+	serial(in, expected, failed);
+	for (unsigned threads = 1 ; threads <= 4 ; ++threads) {
+		JSONParallelDecoder d(in, threads);
+		size_t i = 0;
+		for (;; ++i) {
+			JSON x;
+			bool error = false;
+			try {
+				if (!d.next(x)) break;
+			} catch (runtime_error&) {
+				error = true;
+			}
+			if (i < expected.size())
+				CHECK(error==(bool)failed[i] && (error || x==expected[i]), "value " + to_string(i) + " on " + to_string(threads) + " threads");
+		}
+		CHECK(i==expected.size(), to_string(i) + " values instead of " + to_string(expected.size()) + " on " + to_string(threads) + " threads");
+	}
+}
+
+
+//
+// json_decode_parallel(): arrays of a few chunks, on one to four threads,
+// and the same with an error put somewhere in them, against json_decode()
+//
+static void check_parallel() {
+	// one array of values of all kinds, and one of numbers only, which run
+	// up to the commas where the decoder cuts the elements about 1 MB apart
+	string in[2] = { " [", "[" };
+	while (in[0].size() < (5<<19)) {
+		if (in[0].size() > 2) in[0] += rng()%2 ? ",\n" : ",";
+		in[0] += random_value(1);
+	}
+	in[0] += "] ";
+	while (in[1].size() < (5<<19))
+		in[1] += to_string((int64_t)(rng() >> (rng()%64))) + (rng()%2 ? ",-0.5e-3," : ",");
+	in[1] += "0]";
+
+	for (int round = 0 ; round < 20 ; ++round) {
+		string s = in[round%2];
+		if (round >= 8) {  // removed, added or changed at random, or cut short
+			static const char c[] = "{}[]:,\"\\ ax0";
+			size_t p = rng() % s.size();
+			switch (rng()%4) {
+			case 0: s.erase(p, 1); break;
+			case 1: s.insert(p, 1, c[rng() % (sizeof(c)-1)]); break;
+			case 2: s[p] = c[rng() % (sizeof(c)-1)]; break;
+			default: s.resize(p);
+			}
+		}
+		JSON a, b;
+		string serial, parallel;
+		try {
+			json_decode(s, a);
+		} catch (runtime_error& e) {
+			serial = e.what();
+		}
+		try {
+			json_decode_parallel(s, b, 1 + round/2%4);
+		} catch (runtime_error& e) {
+			parallel = e.what();
+		}
+		// both fail, though not always at the same error, or give the same value
+		CHECK(serial.empty()==parallel.empty() && (!serial.empty() || a==b),
+			"round " + to_string(round) + ": " + serial + " / " + parallel);
+	}
+
+	JSON x;  // too small to cut, and not an array
+	json_decode_parallel("[1,{\"a\":[2]}]", x, 2);
+	CHECK(x==json_decode(string("[1,{\"a\":[2]}]")), "[1,{\"a\":[2]}]");
+	json_decode_parallel("{\"a\":1}", x, 2);
+	CHECK(x==json_decode(string("{\"a\":1}")), "{\"a\":1}");
+}
+
+
+//
+// json_decode_file() and json_decode_file_parallel(): what is written to a
+// file decodes as json_decode() decodes it from a string, with the same
+// errors; a document read from a file still holds after it is removed
+//
+static string decode_error(const string& path, int how) {
+	try {
+		JSON x;
+		JSONDocument doc;
+		if (how==0) json_decode_file(path.c_str(), x);
+		else if (how==1) json_decode_file(path.c_str(), doc);
+		else json_decode_file_parallel(path.c_str(), x, 3);
+	} catch (runtime_error& e) {
+		return e.what();
+	}
+	return "";
+}
+
+static void check_files() {
+	vector<string> inputs(documents, documents + sizeof(documents)/sizeof(*documents));
+	string big = "[";
+	while (big.size() < (3<<20)) big += documents[rng() % inputs.size()] + string(",\n");
+	big += "{}]";
+	inputs.push_back(big);  // cut into several chunks by json_decode_file_parallel()
+
+	for (size_t i = 0 ; i < inputs.size() ; ++i) {
+		const string& s = inputs[i];
+		string path = temp_file(s);
+		JSON x = json_decode(s), y, z;
+		json_decode_file(path.c_str(), y);
+		json_decode_file_parallel(path.c_str(), z, 3);
+		CHECK(y==x && z==x, s);
+		JSONDocument doc;
+		json_decode_file(path.c_str(), doc);
+		unlink(path.c_str());
+		CHECK(doc==x, s + " in a document, after the file is removed");
+		doc.clear();
+		CHECK(doc.type()==JSON_NULL, s);
+	}
+
+	vector<string> errors(broken, broken + sizeof(broken)/sizeof(*broken));
+	errors.push_back("");
+	errors.push_back(" \n");
+	errors.push_back(big.substr(0, big.size()-1));
+	errors.push_back(big + "x");
+	for (size_t b = 0 ; b < errors.size() ; ++b) {
+		string decoded;
+		try {
+			json_decode(errors[b]);
+		} catch (runtime_error& e) {
+			decoded = e.what();
+		}
+		string path = temp_file(errors[b]);
+		for (int how = 0 ; how < 3 ; ++how) {
+			string error = decode_error(path, how);
+			CHECK(!error.empty() && (how==2 || error==decoded), errors[b] + " by way " + to_string(how) + ": " + error + " instead of " + decoded);
+		}
+		unlink(path.c_str());
+	}
+
+	string missing = temp_file("");
+	unlink(missing.c_str());
+	for (int how = 0 ; how < 3 ; ++how)
+		CHECK(decode_error(missing, how).find(missing)==0, missing + " by way " + to_string(how));
+}
+
+
+//
+// json_decode() of @n characters at a pointer, and of a string_view: what
+// follows the @n characters is not read; json_decode_prefix() ends where the
+// value does, whatever follows it
+//
+static string decode_error(const char *s, size_t n, int how) {
+	try {
+		JSON x;
+		JSONDocument doc;
+		if (how==0) json_decode(s, n, x);
+		else if (how==1) json_decode(s, n, doc);
+		else json_decode_borrowed(s, n, doc);
+	} catch (runtime_error& e) {
+		return e.what();
+	}
+	return "";
+}
+
+static void check_inputs() {
+	vector<string> inputs(documents, documents + sizeof(documents)/sizeof(*documents));
+	inputs.insert(inputs.end(), broken, broken + sizeof(broken)/sizeof(*broken));
+	inputs.push_back("");
+	for (size_t i = 0 ; i < inputs.size() ; ++i) {
+		const string& s = inputs[i];
+		JSON x;
+		string decoded;
+		try {
+			json_decode(s, x);
+		} catch (runtime_error& e) {
+			decoded = e.what();
+		}
+		const char *after[] = { "x", "1", "]", "\"", "e5" };  // would change the value, or break it, if read
+		for (size_t a = 0 ; a < sizeof(after)/sizeof(*after) ; ++a) {
+			string t = s + after[a];
+			for (int how = 0 ; how < 3 ; ++how)
+				CHECK(decode_error(t.data(), s.size(), how)==decoded, t + " by way " + to_string(how));
+			if (!decoded.empty()) continue;
+			JSON y;
+			JSONDocument doc;
+			json_decode(t.data(), s.size(), y);
+			json_decode_borrowed(t.data(), s.size(), doc);
+			CHECK(y==x && doc==x, t);
+#if __cplusplus >= 201703L
+			string_view v(t.data(), s.size());
+			json_decode(v, doc);
+			CHECK(json_decode(v)==x && doc==x, t + " as a string_view");
+#endif
+		}
+		if (!decoded.empty()) continue;
+
+		size_t begin = s.find_first_not_of(" \t\r\n"), end = s.find_last_not_of(" \t\r\n") + 1;
+		const char *rest[] = { "", " ", ",x", "]", "[1]", "\n{}" };
+		for (size_t r = 0 ; r < sizeof(rest)/sizeof(*rest) ; ++r) {
+			string t = " " + s.substr(0, end) + rest[r];
+			JSON y;
+			size_t n = json_decode_prefix(t.data(), t.size(), y);
+			CHECK(n==1+end && y==x, t + ": " + to_string(n) + " instead of " + to_string(1+end));
+			n = json_decode_prefix(t.data()+1+begin, t.size()-1-begin, y);
+			CHECK(n==end-begin && y==x, t + " from the start of the value");
+#if __cplusplus >= 201703L
+			CHECK(json_decode_prefix(string_view(t).substr(1+begin), y)==end-begin && y==x, t + " as a string_view");
+#endif
+		}
+	}
+	static const char *none[] = { "", " \n", "]", "x" };
+	for (size_t i = 0 ; i < sizeof(none)/sizeof(*none) ; ++i) {
+		JSON x;
+		bool thrown = false;
+		try {
+			json_decode_prefix(none[i], strlen(none[i]), x);
+		} catch (runtime_error&) {
+			thrown = true;
+		}
+		CHECK(thrown, none[i]);
+	}
+}
+
+
+//
+// JSONLazyDocument: every value reached through JSONLazy, by iteration, by
+// index in order and at random, and by key, against json_decode()
+//
+static void compare(const JSONLazy& l, const JSON& x, const string& in) {
+	CHECK(l.type()==x.type() && l.decode()==x, in);
+	if (l.type()!=x.type()) return;
+	switch (x.type()) {
+	case JSON_BOOLEAN:
+		CHECK(l.boolean()==x.boolean().value(), in);
+		break;
+	case JSON_NUMBER:
+		CHECK(l.number().integer()==x.number().integer() && same(l.number().value(), x.number().value()), in);
+		break;
+	case JSON_STRING:
+		CHECK(l.string()==x.string().value(), in);
+		break;
+	case JSON_ARRAY: {
+		const JSONArray& a = x.array();
+		CHECK(l.size()==a.size() && !l.has(a.size()) && !l.has(-1), in);
+		size_t i = 0;
+		for (JSONLazy::iterator j = l.begin() ; j!=l.end() ; ++j, ++i)
+			if (i < a.size()) compare(*j, a[i], in);
+		CHECK(i==a.size(), in);
+		for (i = 0 ; i < a.size() ; ++i)  // the cursor goes on from one element to the next
+			compare(l[i], a[i], in);
+		for (int k = a.size() ; k-- ; ) {  // and starts over for one before it
+			i = rng() % a.size();
+			CHECK(l.has(i), in);
+			compare(l.get(i), a[i], in);
+		}
+		} break;
+	case JSON_OBJECT: {
+		JSON o = JSONObject();  // the members in input order, the last of repeated keys counting
+		for (JSONLazy::iterator j = l.begin() ; j!=l.end() ; ++j)
+			o[j.key()] = j.value().decode();
+		CHECK(o==x, in);
+		for (JSONObject::const_iterator i = x.object().begin() ; i!=x.object().end() ; ++i) {
+			CHECK(l.has(i->first), in + " at " + i->first);
+			compare(l[i->first], i->second, in);
+		}
+		CHECK(!l.has("not a key") && l.has("")==x.has(""), in);
+		} break;
+	default:
+		break;
+	}
+}
+
+static void check_lazy() {
+	vector<string> in(documents, documents + sizeof(documents)/sizeof(*documents));
+	in.push_back("{\"k\":1,\"k\":{\"x\":2},\"o\":{\"k\":[1],\"k\":[2,3]},\"k\":{\"y\":3}}");
+	in.push_back("{\"a\\u0062\":1,\"ab\":2,\"a\\\"b\":[3],\"ab\\\\\":4,\"a\":{\"ab\":5,\"a\\u0062\":6}}");  // keys with escapes
+	const string spaced = "{\"a\":1,\"b\":2,\"c\" : 3}";
+	in.push_back(spaced);
+	for (int i = 0 ; i < 2000 ; ++i)
+		in.push_back(random_value(0));
+
+	for (size_t d = 0 ; d < in.size() ; ++d) {
+		JSONLazyDocument doc(in[d]);
+		compare(doc.root(), json_decode(in[d]), in[d]);
+	}
+
+	// keys with quotes match no key across the quotes in the input
+	JSONLazyDocument quoted(spaced);
+	const char *across[] = { "a\":1,\"b", "a\"", "b\":2,\"c\" : 3}", "c\" ", "" };
+	for (size_t i = 0 ; i < sizeof(across)/sizeof(*across) ; ++i)
+		CHECK(!quoted.root().has(across[i]), across[i]);
+	CHECK(quoted.root()["c"].number().int64()==3, "c");
+
+	for (size_t b = 0 ; b < sizeof(broken)/sizeof(*broken) ; ++b) {
+		bool thrown = false;
+		try {
+			JSONLazyDocument doc(broken[b]);
+		} catch (runtime_error&) {
+			thrown = true;
+		}
+		CHECK(thrown, broken[b]);
+	}
+}
+
+
+//
+// json_extract(): every value of a document, and some that are not there,
+// against following the same JSON Pointer through what json_decode() gives
+//
+static string escape_token(const string& k) {
+	string s;
+	for (size_t i = 0 ; i < k.size() ; ++i)
+		if (k[i]=='~') s += "~0";
+		else if (k[i]=='/') s += "~1";
+		else s += k[i];
+	return s;
+}
+
+static void pointers(const JSON& x, const string& at, vector<string>& out) {
+	out.push_back(at);
+	if (x.type()==JSON_ARRAY)
+		for (size_t i = 0 ; i < x.array().size() ; ++i)
+			pointers(x[i], at + "/" + to_string(i), out);
+	else if (x.type()==JSON_OBJECT)
+		for (JSONObject::const_iterator i = x.object().begin() ; i!=x.object().end() ; ++i)
+			pointers(i->second, at + "/" + escape_token(i->first), out);
+}
+
+static const JSON *follow(const JSON& x, const string& pointer, size_t at=0) {
+	if (at==pointer.size()) return &x;
+	size_t end = pointer.find('/', at+1);
+	if (end==string::npos) end = pointer.size();
+	string token;
+	for (size_t i = at+1 ; i < end ; ++i)
+		if (pointer[i]=='~' && i+1 < end && (pointer[i+1]=='0' || pointer[i+1]=='1')) token += pointer[++i]=='0' ? '~' : '/';
+		else token += pointer[i];
+	if (x.type()==JSON_OBJECT)
+		return x.has(token) ? follow(x[token], pointer, end) : 0;
+	if (x.type()!=JSON_ARRAY || token.empty() || token.find_first_not_of("0123456789")!=string::npos || (token[0]=='0' && token.size()>1))
+		return 0;
+	size_t i = strtoul(token.c_str(), 0, 10);
+	return i < x.array().size() ? follow(x[i], pointer, end) : 0;
+}
+
+static void check_extract(const string& in, vector<string> extra) {
+	JSON x = json_decode(in);
+	vector<string> all;
+	pointers(x, "", all);
+	all.insert(all.end(), extra.begin(), extra.end());
+	for (size_t i = 0 ; i < all.size() ; ++i) {
+		const JSON *v = follow(x, all[i]);
+		JSON out;
+		bool found = json_extract(in, all[i], out);
+		CHECK(found==(v!=0) && (!v || out==*v), in + " at " + all[i]);
+	}
+
+	for (int round = 0 ; round < 50 ; ++round) {  // several at once, in any order and some twice
+		vector<string> some;
+		for (size_t i = rng()%(all.size()+1) ; i ; --i)
+			some.push_back(all[rng()%all.size()]);
+		vector<JSON> out;
+		size_t found = json_extract(in.data(), in.size(), some, out), expected = 0;
+		CHECK(out.size()==some.size(), in);
+		for (size_t i = 0 ; i < some.size() && i < out.size() ; ++i) {
+			const JSON *v = follow(x, some[i]);
+			if (v) ++expected;
+			CHECK(v ? out[i]==*v : out[i].type()==JSON_NULL, in + " at " + some[i]);
+		}
+		CHECK(found==expected, in);
+	}
+
+	bool thrown = false;
+	try {
+		json_extract(in, "/not/there/at/all");
+	} catch (out_of_range&) {
+		thrown = true;
+	}
+	CHECK(thrown, in);
+}
+
+static void check_extracts() {
+	const char *missing[] = { "/nope", "/0", "/a/99", "/a/-", "/a/01", "/a/1x", "/a/", "//", "/t/x", "/o/a~1b/c" };
+	vector<string> extra(missing, missing + sizeof(missing)/sizeof(*missing));
+	check_extract("{\"a\":[10,{\"b\":[]},[[\"deep\"]],\"\\\"}]\"],\"o\":{\"a/b\":1,\"m~n\":{\"\":2},\"\":[3]},"
+		"\"t\":true, \"n\" : null ,\"s\":\"[{\\\"not\\\":1}]\",\"e\":\"\\u00e9\\n\"}", extra);
+	check_extract("{\"k\":1,\"k\":{\"x\":2},\"o\":{\"k\":[1],\"k\":[2,3]},\"k\":{\"y\":3}}", extra);  // the last of repeated keys
+	check_extract("[1,[2,{\"x\":[3]}],\"/\",[]]", extra);
+	for (size_t d = 0 ; d < sizeof(documents)/sizeof(*documents) ; ++d)
+		check_extract(documents[d], extra);
+
+	const char *invalid[] = { "a", "/~", "/a/~2", "/~/a" };  // are errors, not pointers to nothing
+	for (size_t i = 0 ; i < sizeof(invalid)/sizeof(*invalid) ; ++i) {
+		int thrown = 0;
+		JSON out;
+		vector<JSON> outs;
+		try { json_extract("{\"a\":1}", invalid[i], out); } catch (runtime_error&) { ++thrown; }
+		try { json_extract("{\"a\":1}", vector<string>(1, invalid[i]), outs); } catch (runtime_error&) { ++thrown; }
+		CHECK(thrown==2, invalid[i]);
+	}
+}
+
+
+int main() {
+	try {
+		check_numbers();
+		check_values();
+		check_strings();
+		check_moves();
+		check_sharing();
+		check_objects();
+		check_streams();
+		check_handlers();
+		check_reader();
+		check_push();
+		check_batch();
+		check_parallel();
+		check_files();
+		check_inputs();
+		check_lazy();
+		check_extracts();
+		check_documents();
+	} catch (exception& e) {  // from a check that went wrong enough not to finish
+		fail(__LINE__, e.what(), "");
+	}
+
+	if (failures)
+		cerr << failures << " checks failed" << endl;
+	return failures < 100 ? failures : 100;
+}
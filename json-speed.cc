@@ -1,5 +1,6 @@
 //
-// program that measures the time it takes to decode JSON expressions
+// program that measures the time it takes to decode JSON expressions: a
+// line of stdin, or with an argument, a file
 //
 #include <sys/time.h>
 
@@ -16,6 +17,26 @@ inline double doubletime() {
 }
 
 int main(int argc, char **argv) {
+	if (argc > 1) {
+		JSON json;
+
+		{ double t = doubletime();
+		json_decode_file(argv[1], json);
+		json.set(0);
+		t = doubletime() - t;
+		cout << t << endl; }
+
+		JSONDocument doc;
+
+		{ double t = doubletime();
+		json_decode_file(argv[1], doc);
+		doc.clear();
+		t = doubletime() - t;
+		cout << t << endl; }
+
+		return 0;
+	}
+
 	string in;
 
 	{ double t = doubletime();
@@ -30,4 +51,18 @@ int main(int argc, char **argv) {
 	json.set(0);
 	t = doubletime() - t;
 	cout << t << endl; }
+
+	JSONDocument doc;
+
+	{ double t = doubletime();
+	json_decode(in, doc);
+	doc.clear();
+	t = doubletime() - t;
+	cout << t << endl; }
+
+	{ double t = doubletime();
+	json_decode_borrowed(in, doc);
+	doc.clear();
+	t = doubletime() - t;
+	cout << t << endl; }
 }
@@ -1,12 +1,35 @@
 //
-// simple input-output loop which handles JSON expressions, one per line
+// simple input-output loop which handles JSON expressions, one per line;
+// with -j [THREADS], all of stdin is decoded on several threads instead,
+// and only echoed back
 //
 #include <iostream>
+#include <iterator>
+#include <string.h>
+#include <stdlib.h>
 using namespace std;
 
 #include <stajson.h>
 
 int main(int argc, char **argv) {
+	ios::sync_with_stdio(false);  // gives cin a buffer that json_decode() can read from
+
+	if (argc > 1 && strcmp(argv[1],"-j")==0) {
+		string in((istreambuf_iterator<char>(cin)), istreambuf_iterator<char>());
+		JSONParallelDecoder values(in, argc > 2 ? atoi(argv[2]) : 0);
+		for (;;) {
+			JSON json;
+			try {
+				if (!values.next(json)) break;
+			} catch (runtime_error& e) {
+				cerr << e.what() << endl;
+				continue;
+			}
+			cout << json << '\n';
+		}
+		return 0;
+	}
+
 	cerr <<
 "This program will read lines form stdin in JSON format, decode them, encode\n"
 "them and echo them back to stdout, along with a short description on stderr."
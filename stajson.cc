@@ -3,10 +3,120 @@
 #endif
 #include <stajson.h>
 #include <string.h>
+#include <math.h>
+#include <locale.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define JSON_AVX2 1
+#endif
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
 
 using namespace std;
 
-static std::string::const_iterator json_decode(const std::string& in, std::string::const_iterator pos, JSON& out);
+struct json_context {  // where the decoder puts what it decodes
+	JSONArena *arena;
+	bool borrow;  // strings without escapes refer to the input
+	json_context(JSONArena *arena=0, bool borrow=false) : arena(arena), borrow(borrow) { }
+};
+
+static void json_decode(const char *s, size_t n, JSON& out, const json_context& cx);
+static void json_decode(std::istream& in, JSON& out, const json_context& cx);
+
+const unsigned char JSONSmallMap::SMALL;
+size_t json_max_depth = 1024;
+
+
+//
+// arena memory
+//
+void *JSONArena::grow(size_t n, size_t align) {
+	size_t size = next;
+	if (size < sizeof(Block)+n+align)
+		size = sizeof(Block)+n+align;
+	if (next < (1<<24))
+		next *= 2;
+
+	Block *b = (Block*)::operator new(size);
+	b->next = blocks;
+	blocks = b;
+	end = (char*)b + size;
+
+	char *p = (char*)(((size_t)(b+1) + align-1) & ~(align-1));
+	pos = p+n;
+	return p;
+}
+void JSONArena::release() {
+	for (Cleanup *c = cleanups ; c ; c = c->next)
+		c->f(c->p);
+	cleanups = 0;
+
+	while (blocks) {
+		Block *b = blocks->next;
+		::operator delete(blocks);
+		blocks = b;
+	}
+	pos = end = 0;
+	next = 4096;
+}
+
+// whether @s keeps its characters in a heap buffer, rather than inside itself
+static inline bool json_heap_string(const std::string& s) {
+	const char *p = s.data();
+	return p < (const char*)&s || p >= (const char*)(&s+1);
+}
+
+//
+// nodes of a JSONDocument are allocated in its arena; strings that could
+// not fit in it are destroyed when the arena is released
+//
+static inline JSONArray *json_new_array(JSONArena *arena) {
+	if (!arena) return JSONBase::make<JSONArray>();
+	return arena->make<JSONArray>(JSONArray::allocator_type(arena));
+}
+static inline JSONObject *json_new_object(JSONArena *arena) {
+	if (!arena) return JSONBase::make<JSONObject>();
+	return arena->make<JSONObject>(JSONObject::allocator_type(arena));
+}
+static inline void json_set_string(JSON& out, std::string& s, JSONArena *arena) {
+	if (!arena) {
+		out = std::move(s);
+		return;
+	}
+	JSONString *p = arena->make<JSONString>(std::move(s));
+	if (json_heap_string(p->value()))
+		arena->own(p);
+	out.set(p);
+}
+static inline void json_set_string(JSON& out, const char *s, size_t n, const json_context& cx) {
+	if (!cx.arena) {
+		out.set(JSONBase::make<JSONString>(s, n, cx.borrow));
+		return;
+	}
+	JSONString *p = cx.arena->make<JSONString>(s, n, cx.borrow);
+	if (cx.borrow ? n > std::string().capacity() : json_heap_string(p->value()))
+		cx.arena->own(p);  // borrowed strings may still be copied into a heap buffer
+	out.set(p);
+}
+static inline JSON& json_member(JSONObject& object, const std::string& key, JSONArena *arena, bool& owned) {
+	// @owned: the destructor of @object already runs on release
+	std::pair<JSONObject::iterator,bool> i = object.emplace(key, JSON());
+	if (arena && !owned && json_heap_string(i.first->first)) {
+		arena->own(&object);
+		owned = true;
+	}
+	return i.first->second;
+}
 
 //
 // boolean encoding
@@ -19,67 +129,353 @@ void json_encode(const JSONBool& in, ostream& out) {
 }
 
 //
-// number encoding
+// number encoding: the shortest digits that read back as the same double
+// are found with Grisu2 (Loitsch), which works in 64-bit integers against a
+// table of cached powers of ten, and laid out like printf("%g") would; for
+// the few doubles where Grisu2 cannot tell that its digits are the shortest,
+// printf() is asked for fewer
 //
+struct json_diyfp {  // f * 2^e
+	uint64_t f;
+	int e;
+	json_diyfp(uint64_t f, int e) : f(f), e(e) { }
+};
+
+static inline json_diyfp json_mul(const json_diyfp& x, const json_diyfp& y) {  // the upper 64 bits of the product, rounded
+	uint64_t u_lo = x.f & 0xFFFFFFFF, u_hi = x.f >> 32;
+	uint64_t v_lo = y.f & 0xFFFFFFFF, v_hi = y.f >> 32;
+	uint64_t p0 = u_lo*v_lo, p1 = u_lo*v_hi, p2 = u_hi*v_lo, p3 = u_hi*v_hi;
+	uint64_t q = (p0 >> 32) + (p1 & 0xFFFFFFFF) + (p2 & 0xFFFFFFFF) + ((uint64_t)1 << 31);
+	return json_diyfp(p3 + (p2 >> 32) + (p1 >> 32) + (q >> 32), x.e + y.e + 64);
+}
+
+static inline json_diyfp json_normalize(json_diyfp x) {
+	while (!(x.f >> 63)) {
+		x.f <<= 1;
+		--x.e;
+	}
+	return x;
+}
+
+struct json_cached_power {  // f * 2^e, about 10^k
+	uint64_t f;
+	int e;
+	int k;
+};
+
+static const json_cached_power json_cached_powers[] = {  // k = -300...324, in steps of 8
+	{0xAB70FE17C79AC6CA,-1060,-300}, {0xFF77B1FCBEBCDC4F,-1034,-292}, {0xBE5691EF416BD60C,-1007,-284},
+	{0x8DD01FAD907FFC3C,-980,-276}, {0xD3515C2831559A83,-954,-268}, {0x9D71AC8FADA6C9B5,-927,-260},
+	{0xEA9C227723EE8BCB,-901,-252}, {0xAECC49914078536D,-874,-244}, {0x823C12795DB6CE57,-847,-236},
+	{0xC21094364DFB5637,-821,-228}, {0x9096EA6F3848984F,-794,-220}, {0xD77485CB25823AC7,-768,-212},
+	{0xA086CFCD97BF97F4,-741,-204}, {0xEF340A98172AACE5,-715,-196}, {0xB23867FB2A35B28E,-688,-188},
+	{0x84C8D4DFD2C63F3B,-661,-180}, {0xC5DD44271AD3CDBA,-635,-172}, {0x936B9FCEBB25C996,-608,-164},
+	{0xDBAC6C247D62A584,-582,-156}, {0xA3AB66580D5FDAF6,-555,-148}, {0xF3E2F893DEC3F126,-529,-140},
+	{0xB5B5ADA8AAFF80B8,-502,-132}, {0x87625F056C7C4A8B,-475,-124}, {0xC9BCFF6034C13053,-449,-116},
+	{0x964E858C91BA2655,-422,-108}, {0xDFF9772470297EBD,-396,-100}, {0xA6DFBD9FB8E5B88F,-369,-92},
+	{0xF8A95FCF88747D94,-343,-84}, {0xB94470938FA89BCF,-316,-76}, {0x8A08F0F8BF0F156B,-289,-68},
+	{0xCDB02555653131B6,-263,-60}, {0x993FE2C6D07B7FAC,-236,-52}, {0xE45C10C42A2B3B06,-210,-44},
+	{0xAA242499697392D3,-183,-36}, {0xFD87B5F28300CA0E,-157,-28}, {0xBCE5086492111AEB,-130,-20},
+	{0x8CBCCC096F5088CC,-103,-12}, {0xD1B71758E219652C,-77,-4}, {0x9C40000000000000,-50,4},
+	{0xE8D4A51000000000,-24,12}, {0xAD78EBC5AC620000,3,20}, {0x813F3978F8940984,30,28},
+	{0xC097CE7BC90715B3,56,36}, {0x8F7E32CE7BEA5C70,83,44}, {0xD5D238A4ABE98068,109,52},
+	{0x9F4F2726179A2245,136,60}, {0xED63A231D4C4FB27,162,68}, {0xB0DE65388CC8ADA8,189,76},
+	{0x83C7088E1AAB65DB,216,84}, {0xC45D1DF942711D9A,242,92}, {0x924D692CA61BE758,269,100},
+	{0xDA01EE641A708DEA,295,108}, {0xA26DA3999AEF774A,322,116}, {0xF209787BB47D6B85,348,124},
+	{0xB454E4A179DD1877,375,132}, {0x865B86925B9BC5C2,402,140}, {0xC83553C5C8965D3D,428,148},
+	{0x952AB45CFA97A0B3,455,156}, {0xDE469FBD99A05FE3,481,164}, {0xA59BC234DB398C25,508,172},
+	{0xF6C69A72A3989F5C,534,180}, {0xB7DCBF5354E9BECE,561,188}, {0x88FCF317F22241E2,588,196},
+	{0xCC20CE9BD35C78A5,614,204}, {0x98165AF37B2153DF,641,212}, {0xE2A0B5DC971F303A,667,220},
+	{0xA8D9D1535CE3B396,694,228}, {0xFB9B7CD9A4A7443C,720,236}, {0xBB764C4CA7A44410,747,244},
+	{0x8BAB8EEFB6409C1A,774,252}, {0xD01FEF10A657842C,800,260}, {0x9B10A4E5E9913129,827,268},
+	{0xE7109BFBA19C0C9D,853,276}, {0xAC2820D9623BF429,880,284}, {0x80444B5E7AA7CF85,907,292},
+	{0xBF21E44003ACDD2D,933,300}, {0x8E679C2F5E44FF8F,960,308}, {0xD433179D9C8CB841,986,316},
+	{0x9E19DB92B4E31BA9,1013,324}
+};
+
+static void json_grisu2_round(char *buf, int len, uint64_t dist, uint64_t delta, uint64_t rest, uint64_t ten_k) {
+	// moves the last digit towards the exact value, as long as it stays
+	// within the rounding interval
+	while (rest < dist && delta - rest >= ten_k && (rest + ten_k < dist || dist - rest > rest + ten_k - dist)) {
+		--buf[len-1];
+		rest += ten_k;
+	}
+}
+
+static bool json_grisu2_digits(const json_diyfp& w, const json_diyfp& lo, const json_diyfp& hi, char *buf, int& len, int& exponent) {
+	// the shortest digits within @lo...@hi, the nearest to @w, all scaled
+	// alike; @exponent is adjusted for how many there are; returns whether
+	// bounds 2 wider on each side might give fewer digits: when it would have
+	// taken the rest 2 lower to stop at an earlier digit, or @hi 2 higher
+	// carries into them
+	uint64_t err = 2;  // as scaled along with the rest
+	bool close = false;
+	uint64_t delta = hi.f - lo.f;
+	uint64_t dist = hi.f - w.f;
+	int shift = -hi.e;
+	uint64_t one = (uint64_t)1 << shift;
+	uint32_t p1 = (uint32_t)(hi.f >> shift);
+	uint64_t p2 = hi.f & (one - 1);
+
+	uint32_t pow10 = 1;
+	int n = 1;
+	while (n < 10 && p1 >= pow10*10) {
+		pow10 *= 10;
+		++n;
+	}
+	len = 0;
+	while (n > 0) {
+		buf[len++] = (char)('0' + p1 / pow10);
+		p1 %= pow10;
+		--n;
+		uint64_t rest = ((uint64_t)p1 << shift) + p2;
+		if (rest <= delta) {
+			exponent += n;
+			json_grisu2_round(buf, len, dist, delta, rest, (uint64_t)pow10 << shift);
+			return close || rest + err >= (uint64_t)pow10 << shift;
+		}
+		close = close || rest - delta <= err;
+		pow10 /= 10;
+	}
+	for (;;) {
+		p2 *= 10;
+		buf[len++] = (char)('0' + (p2 >> shift));
+		p2 &= one - 1;
+		--exponent;
+		delta *= 10;
+		dist *= 10;
+		err = err < one ? err*10 : one;
+		if (p2 <= delta)
+			break;
+		close = close || p2 - delta <= err;
+	}
+	json_grisu2_round(buf, len, dist, delta, p2, one);
+	return close || err >= one - p2;
+}
+
+static void json_shortest(double value, char *buf, int& len, int& exponent, int from) {
+	// looks for fewer than @len digits, from @from on, that read back as
+	// @value; printf() rounds correctly, so the digits it gives are the
+	// ones to try for each length
+	for (int n = from ; n < len ; ++n) {
+		char s[32];
+		snprintf(s, sizeof(s), "%.*e", n-1, value);
+		if (strtod(s, 0)!=value)
+			continue;
+		const char *p = s;
+		len = 0;
+		for (; *p!='e' ; ++p)
+			if (*p>='0' && *p<='9')
+				buf[len++] = *p;
+		exponent = atoi(p+1) - (len-1);
+		return;
+	}
+}
+
+static void json_grisu2(double value, char *buf, int& len, int& exponent) {
+	// the digits of @value, positive and finite, in @buf, with @value being
+	// about @buf * 10^@exponent
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	uint64_t F = bits & (((uint64_t)1 << 52) - 1);
+	int E = (int)(bits >> 52);
+	json_diyfp v = E ? json_diyfp(F + ((uint64_t)1 << 52), E - 1075) : json_diyfp(F, 1 - 1075);
+
+	// boundaries of the values that round to @value
+	json_diyfp plus = json_normalize(json_diyfp(2*v.f + 1, v.e - 1));
+	json_diyfp minus = F==0 && E > 1 ? json_diyfp(4*v.f - 1, v.e - 2) : json_diyfp(2*v.f - 1, v.e - 1);
+	minus = json_diyfp(minus.f << (minus.e - plus.e), plus.e);
+	v = json_normalize(v);
+
+	// scale by a cached power of ten, so that the exponent is in -60...-32
+	int f = -60 - plus.e - 1;
+	int k = (f * 78913) / (1 << 18) + (f > 0);
+	const json_cached_power& cached = json_cached_powers[(300 + k + 7) / 8];
+	json_diyfp c(cached.f, cached.e);
+	json_diyfp w = json_mul(v, c);
+	json_diyfp lo = json_mul(minus, c);
+	json_diyfp hi = json_mul(plus, c);
+
+	// the bounds are narrowed by the error of the products, which can cost a
+	// digit; when the bounds widened by it allow fewer, fewer may do
+	exponent = -cached.k;
+	if (json_grisu2_digits(w, json_diyfp(lo.f+1, lo.e), json_diyfp(hi.f-1, hi.e), buf, len, exponent)) {
+		char wide[20];
+		int wide_len, wide_exponent = -cached.k;
+		json_grisu2_digits(w, json_diyfp(lo.f-1, lo.e), json_diyfp(hi.f+1, hi.e), wide, wide_len, wide_exponent);
+		if (wide_len < len)
+			json_shortest(value, buf, len, exponent, wide_len);
+	}
+}
+
+static char *json_itoa(uint64_t x, char *p) {  // writes @x at @p, and returns the end
+	char digits[20];
+	int n = 0;
+	do {
+		digits[n++] = (char)('0' + x % 10);
+		x /= 10;
+	} while (x);
+	while (n)
+		*p++ = digits[--n];
+	return p;
+}
+
+static size_t json_format_number(double value, char *out) {
+	// writes @value, which is read back as the same double, to @out, at
+	// least 32 characters, and returns its length
+	char *p = out;
+	if (value!=value) {
+		memcpy(p, "nan", 3);
+		return 3;
+	}
+	if (signbit(value)) {
+		*p++ = '-';
+		value = -value;
+	}
+	if (value==HUGE_VAL) {
+		memcpy(p, "inf", 3);
+		return (size_t)(p+3 - out);
+	}
+	if (value < 9007199254740992.0 && value==(double)(uint64_t)value)  // integer
+		return (size_t)(json_itoa((uint64_t)value, p) - out);
+
+	char digits[20];
+	int len, exponent;
+	json_grisu2(value, digits, len, exponent);
+
+	int point = len + exponent;  // digits before the decimal point
+	if (point > 17 || point < -3) {  // d.igitse+XX
+		*p++ = digits[0];
+		if (len > 1) {
+			*p++ = '.';
+			memcpy(p, digits+1, len-1);
+			p += len-1;
+		}
+		int e = point-1;
+		*p++ = 'e';
+		*p++ = e < 0 ? '-' : '+';
+		if (e < 0)
+			e = -e;
+		if (e < 10)
+			*p++ = '0';
+		p = json_itoa(e, p);
+	} else if (point <= 0) {  // 0.[000]digits
+		*p++ = '0';
+		*p++ = '.';
+		memset(p, '0', -point);
+		p += -point;
+		memcpy(p, digits, len);
+		p += len;
+	} else if (point < len) {  // dig.its
+		memcpy(p, digits, point);
+		p += point;
+		*p++ = '.';
+		memcpy(p, digits+point, len-point);
+		p += len-point;
+	} else {  // digits[000]
+		memcpy(p, digits, len);
+		p += len;
+		memset(p, '0', point-len);
+		p += point-len;
+	}
+	return (size_t)(p - out);
+}
+
+static size_t json_format_number(const JSONNumber& in, char *out) {
+	if (!in.integer())
+		return json_format_number(in.value(), out);
+	int64_t i = in.int64();
+	char *p = out;
+	if (i < 0)
+		*p++ = '-';
+	return (size_t)(json_itoa(i < 0 ? 0-(uint64_t)i : (uint64_t)i, p) - out);
+}
+
 void json_encode(const JSONNumber& in, std::string& out) {
-	out.append(json_fmt("%.15g",(double)in));  // XXX is this right?
+	char buf[32];
+	out.append(buf, json_format_number(in, buf));
 }
 void json_encode(const JSONNumber& in, ostream& out) {
-	out.flags(ios::fmtflags());
-	out.precision(15);
-	out << (double)in;
+	char buf[32];
+	out.write(buf, json_format_number(in, buf));
 }
 
 
 //
 // string encoding
 //
+static inline unsigned json_ctz(uint64_t x) {  // @x is not 0
+#ifdef __GNUC__
+	return __builtin_ctzll(x);
+#else
+	unsigned n = 0;
+	for (; !(x & 1) ; x >>= 1) ++n;
+	return n;
+#endif
+}
+
+static inline const char *json_escape_run(const char *p, const char *end) {  // the first character from @p that needs escaping, or @end
+#ifdef __SSE2__
+	const __m128i quote = _mm_set1_epi8('"'), backslash = _mm_set1_epi8('\\'), control = _mm_set1_epi8(0x1f);
+	for (; end-p >= 16 ; p += 16) {
+		__m128i c = _mm_loadu_si128((const __m128i*)p);
+		__m128i hit = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(c, quote), _mm_cmpeq_epi8(c, backslash)),
+			_mm_cmpeq_epi8(_mm_min_epu8(c, control), c));  // below 0x20
+		unsigned bits = _mm_movemask_epi8(hit);
+		if (bits)
+			return p + json_ctz(bits);
+	}
+#endif
+	while (p!=end && *p!='"' && *p!='\\' && (unsigned char)*p>=0x20)
+		++p;
+	return p;
+}
+
+static inline const char *json_escape(char c, char *u) {  // the escape sequence of @c, in @u if it has no short form
+	switch (c) {
+	case '"': return "\\\"";
+	case '\\': return "\\\\";
+	case '\b': return "\\b";
+	case '\f': return "\\f";
+	case '\n': return "\\n";
+	case '\r': return "\\r";
+	case '\t': return "\\t";
+	default:
+		snprintf(u, 7, "\\u%.4x", (unsigned char)c);
+		return u;
+	}
+}
+
 void json_encode(const JSONString& in, std::string& out) {
-	const std::string& s = in;
+	const char *p = in.data();
+	const char *end = p + in.size();
 
 	out.push_back('"');
-	for (size_t i = 0 ; i < s.length() ; ++i) {
-		switch (s[i]) {
-		case '"': out.append("\\\""); break;
-		case '\\': out.append("\\\\"); break;
-		case '\b': out.append("\\b"); break;
-		case '\f': out.append("\\f"); break;
-		case '\n': out.append("\\n"); break;
-		case '\r': out.append("\\r"); break;
-		case '\t': out.append("\\t"); break;
-		default:
-			if (s[i]<32) {
-				out.append(json_fmt("\\u%.4x", (unsigned char)s[i]));
-			} else {
-				out.push_back(s[i]);
-			}
-		}
+	for (;;) {
+		const char *q = json_escape_run(p, end);
+		out.append(p, q);
+		if (q==end)
+			break;
+		char u[7];
+		out.append(json_escape(*q, u));
+		p = q+1;
 	}
 	out.push_back('"');
 }
 void json_encode(const JSONString& in, ostream& out) {
-	const std::string& s = in;
+	const char *p = in.data();
+	const char *end = p + in.size();
 
 	out << '"';
-	for (size_t i = 0 ; i < s.length() ; ++i) {
-		switch (s[i]) {
-		case '"': out << "\\\""; break;
-		case '\\': out << "\\\\"; break;
-		case '\b': out << "\\b"; break;
-		case '\f': out << "\\f"; break;
-		case '\n': out << "\\n"; break;
-		case '\r': out << "\\r"; break;
-		case '\t': out << "\\t"; break;
-		default:
-			if (s[i]<32) {
-				out.flags(ios::hex | ios::right);
-				out.width(4);
-				out.fill('0');
-				out << (unsigned int)s[i];
-			} else {
-				out << s[i];
-			}
-		}
+	for (;;) {
+		const char *q = json_escape_run(p, end);
+		out.write(p, q-p);
+		if (q==end)
+			break;
+		char u[7];
+		out << json_escape(*q, u);
+		p = q+1;
 	}
 	out << '"';
 }
@@ -164,938 +560,2539 @@ void json_encode(const JSON& in, ostream& out) {
 
 
 //
-// decoding from string
+// copy-on-write
 //
-void json_decode(const std::string& in, JSON& out) {
-	std::string::const_iterator p = json_decode(in,in.begin(),out);
-	for (; p != in.end() ; ++p) {
-		switch (*p) {
-		case ' ': case '\t': case '\r': case '\n':
-			break;
-		default:
-			throw runtime_error(json_fmt("%d: JSON syntax error",p-in.begin()));
-		}
+void JSON::share() {
+	if (!boxed() || (node()->f & JSONBase::ARENA))
+		return;
+
+	node()->f |= JSONBase::SHARED;
+	switch (type()) {
+	case JSON_ARRAY: {
+		JSONArray& a = *(JSONArray*)node();
+		for (JSONArray::iterator i=a.begin() ; i!=a.end() ; ++i)
+			i->share();
+		} break;
+	case JSON_OBJECT: {
+		JSONObject& o = *(JSONObject*)node();
+		for (JSONObject::iterator i=o.begin() ; i!=o.end() ; ++i)
+			i->second.share();
+		} break;
+	default:
+		break;
 	}
 }
-std::string::const_iterator json_decode(const std::string& in, std::string::const_iterator start, JSON& out) {
-	int state = 0;
-	std::string::const_iterator pos;
-	std::string *str = 0;
-	JSONArray *array=0;
-	JSONObject *object=0;
-	JSON key;
-	for (pos=start ; pos!=in.end() ; ++pos) {
-		switch (state) {
-		case 0:
-			switch (*pos) {
-			case ' ': case '\t': case '\r': case '\n':
-				++start;
-				break;
-
-			case 'n':
-				if (in.end()-pos<4 || strncmp(&*pos,"null",4)!=0)
-					throw runtime_error(json_fmt("%d: JSON syntax error: expected \"null\"",pos-in.begin()));
-
-				pos+=4;
-				//state=1;
-				goto accept_null;
-
-			case 'f':
-				if (in.end()-pos<5 || strncmp(&*pos,"false",5)!=0)
-					throw runtime_error(json_fmt("%d: JSON syntax error: expected \"false\"",pos-in.begin()));
 
-				pos+=5;
-				//state=2;
-				goto accept_false;
-			case 't':
-				if (in.end()-pos<4 || strncmp(&*pos,"true",4)!=0)
-					throw runtime_error(json_fmt("%d: JSON syntax error: expected \"true\"",pos-in.begin()));
 
-				pos+=4;
-				//state=3;
-				goto accept_true;
-
-			case '-':
-				state=4;
-				break;
-			case '0':
-				state=6;
-				break;
-			case '1': case '2': case '3':
-			case '4': case '5': case '6':
-			case '7': case '8': case '9':
-				state=5;
-				break;
+////////////////////////////////////////////////////////////////////////////////
 
-			case '"':
-				str = new string();
-				state=12;
-				break;
-			case '[':
-				array = new JSONArray();
-				state=15;
-				break;
-			case '{':
-				object = new JSONObject();
-				state=19;
-				break;
-			default:
-				throw runtime_error(json_fmt("%d: JSON syntax error: invalid token",pos-in.begin()));
-			}
-			break;
 
-		//
-		// NULL
-		//
-		//case 1:  // after null
-		//	goto accept_null;
-
-		//
-		// BOOLEAN
-		//
-		//case 2:  // after true
-		//	goto accept_true;
-		//case 3:  // after false
-		//	goto accept_false;
-
-		//
-		// NUMBER
-		//
-		case 4:  // after minus sign
-			switch (*pos) {
-			case '1': case '2': case '3':
-			case '4': case '5': case '6':
-			case '7': case '8': case '9':
-				state=5;
-				break;
-			case '0':
-				state=6;
-				break;
-			default:
-				throw runtime_error(json_fmt("%d: JSON syntax error: expected digit after minus sign",pos-in.begin()));
-			}
-			break;
-		case 5:  // after first digit
-			switch (*pos) {
-			case '0': case '1': case '2': case '3': case '4':
-			case '5': case '6': case '7': case '8': case '9':
-				break;
-			case '.':
-				state=7;
-				break;
-			case 'E': case 'e':
-				state=9;
-				break;
-			default:
-				goto accept_number;
-			}
-			break;
-		case 6:  // after zero first digit
-			switch (*pos) {
-			case '.':
-				state=7;
-				break;
-			case 'E': case 'e':
-				state=9;
-				break;
-			default:
-				goto accept_number;
-			}
-			break;
-		case 7:  // after decimal point
-			switch (*pos) {
-			case '0': case '1': case '2': case '3': case '4':
-			case '5': case '6': case '7': case '8': case '9':
-				state=8;
-				break;
-			default:
-				throw runtime_error(json_fmt("%d: JSON syntax error: expected digit after decimal point",pos-in.begin()));
-			}
-			break;
-		case 8:  // after first decimal digit
-			switch (*pos) {
-			case '0': case '1': case '2': case '3': case '4':
-			case '5': case '6': case '7': case '8': case '9':
-				break;
-			case 'E': case 'e':
-				state=9;
-				break;
-			default:
-				goto accept_number;
-			}
-			break;
-		case 9:  // after E
-			switch (*pos) {
-			case '+': case '-':
-				state=10;
-				break;
-			case '0': case '1': case '2': case '3': case '4':
-			case '5': case '6': case '7': case '8': case '9':
-				state=11;
-				break;
-			default:
-				throw runtime_error(json_fmt("%d: JSON syntax error: expected digit after 'E'",pos-in.begin()));
-			}
-			break;
-		case 10:  // after E+ or E-
-			switch (*pos) {
-			case '0': case '1': case '2': case '3': case '4':
-			case '5': case '6': case '7': case '8': case '9':
-				state=11;
-				break;
-			default:
-				throw runtime_error(json_fmt("%d: JSON syntax error: expected digit after 'E+' or 'E-'",pos-in.begin()));
-			}
-			break;
-		case 11:  // after first exponent digit
-			switch (*pos) {
-			case '0': case '1': case '2': case '3': case '4':
-			case '5': case '6': case '7': case '8': case '9':
-				break;
-			default:
-				goto accept_number;
-			}
-			break;
+//
+// structural index
+//
+// stage 1 of decoding from a string: every 64-byte block of the input is
+// classified into bit masks, one bit per character, and from those the
+// positions of {}[]:, outside strings, of the quotes that open strings and of
+// the first characters of other tokens are collected, without branching on
+// the characters themselves; stage 2 then only visits those positions, a
+// window of the input at a time, while it is still in cache
+//
+#ifndef __SSE2__
+static void json_classify(const char *p, json_masks& m) {  // the portable classifier, for targets without SSE2
+	m.quote = m.backslash = m.op = m.space = 0;
+	for (size_t i = 0 ; i < 64 ; ++i) {
+		uint64_t bit = (uint64_t)1 << i;
+		switch (p[i]) {
+		case '"': m.quote |= bit; break;
+		case '\\': m.backslash |= bit; break;
+		case '{': case '}': case '[': case ']': case ':': case ',': m.op |= bit; break;
+		case ' ': case '\t': case '\r': case '\n': m.space |= bit; break;
+		}
+	}
+}
+#else
+static void json_classify_sse2(const char *p, json_masks& m) {
+	m.quote = m.backslash = m.op = m.space = 0;
+	for (int i = 0 ; i < 4 ; ++i) {
+		__m128i c = _mm_loadu_si128((const __m128i*)(p+16*i));
+		__m128i l = _mm_or_si128(c, _mm_set1_epi8(0x20));  // { } from [ ]
+		__m128i op = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(l, _mm_set1_epi8('{')), _mm_cmpeq_epi8(l, _mm_set1_epi8('}'))),
+			_mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8(':')), _mm_cmpeq_epi8(c, _mm_set1_epi8(','))));
+		__m128i space = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(c, _mm_set1_epi8('\t'))),
+			_mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(c, _mm_set1_epi8('\n'))));
+		m.quote |= (uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(c, _mm_set1_epi8('"'))) << 16*i;
+		m.backslash |= (uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(c, _mm_set1_epi8('\\'))) << 16*i;
+		m.op |= (uint64_t)(unsigned)_mm_movemask_epi8(op) << 16*i;
+		m.space |= (uint64_t)(unsigned)_mm_movemask_epi8(space) << 16*i;
+	}
+}
+#endif
+#ifdef JSON_AVX2
+__attribute__((target("avx2")))
+static void json_classify_avx2(const char *p, json_masks& m) {
+	m.quote = m.backslash = m.op = m.space = 0;
+	for (int i = 0 ; i < 2 ; ++i) {
+		__m256i c = _mm256_loadu_si256((const __m256i*)(p+32*i));
+		__m256i l = _mm256_or_si256(c, _mm256_set1_epi8(0x20));
+		__m256i op = _mm256_or_si256(
+			_mm256_or_si256(_mm256_cmpeq_epi8(l, _mm256_set1_epi8('{')), _mm256_cmpeq_epi8(l, _mm256_set1_epi8('}'))),
+			_mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8(':')), _mm256_cmpeq_epi8(c, _mm256_set1_epi8(','))));
+		__m256i space = _mm256_or_si256(
+			_mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(c, _mm256_set1_epi8('\t'))),
+			_mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('\r')), _mm256_cmpeq_epi8(c, _mm256_set1_epi8('\n'))));
+		m.quote |= (uint64_t)(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('"'))) << 32*i;
+		m.backslash |= (uint64_t)(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('\\'))) << 32*i;
+		m.op |= (uint64_t)(unsigned)_mm256_movemask_epi8(op) << 32*i;
+		m.space |= (uint64_t)(unsigned)_mm256_movemask_epi8(space) << 32*i;
+	}
+}
+#endif
 
-		//
-		// STRING
-		//
-		case 12:  // after opening quotes
-			switch (*pos) {
-			case '"':
-				//state=13;
-				++pos;
-				goto accept_string;
-			case '\\':
-				state=14;
-				break;
-			default:
-				str->push_back(*pos);
-			}
-			break;
-		//case 13:  // after closing quotes
-		//	goto accept_string;
-		case 14:  // after backslash
-			switch (*pos) {
-			case '"': case '\\': case '/':
-				str->push_back(*pos);
-				break;
-			case 'b':
-				str->push_back('\b');
-				break;
-			case 'f':
-				str->push_back('\f');
-				break;
-			case 'n':
-				str->push_back('\n');
-				break;
-			case 'r':
-				str->push_back('\r');
-				break;
-			case 't':
-				str->push_back('\t');
-				break;
-			case 'u': {
-				if (in.end()-pos < 4) {
-					delete str; str = 0;
-					throw runtime_error(json_fmt("%d: JSON syntax error: expected at least 4 characters after '\\u'",pos-in.begin()));
-				}
-				
-				unsigned long hex=0;
-				size_t i;
-				for (i = 0 ; i < 4 ; ++i) {
-					++pos;
-					hex *= 16;
-					switch (*pos) {
-					case '0': hex += 0; break;
-					case '1': hex += 1; break;
-					case '2': hex += 2; break;
-					case '3': hex += 3; break;
-					case '4': hex += 4; break;
-					case '5': hex += 5; break;
-					case '6': hex += 6; break;
-					case '7': hex += 7; break;
-					case '8': hex += 8; break;
-					case '9': hex += 9; break;
-					case 'a': case 'A': hex += 10; break;
-					case 'b': case 'B': hex += 11; break;
-					case 'c': case 'C': hex += 12; break;
-					case 'd': case 'D': hex += 13; break;
-					case 'e': case 'E': hex += 14; break;
-					case 'f': case 'F': hex += 15; break;
-					default:
-						goto endhex;
-					}
-				}
-				endhex:
+static json_classifier json_best_classifier() {
+#ifdef JSON_AVX2
+	static const bool avx2 = (__builtin_cpu_init(), __builtin_cpu_supports("avx2"));
+	if (avx2) return json_classify_avx2;
+#endif
+#ifdef __SSE2__
+	return json_classify_sse2;
+#else
+	return json_classify;
+#endif
+}
 
-				if (!i) {
-					delete str; str = 0;
-					throw runtime_error(json_fmt("%d: JSON syntax error: no hex digits follow '\\u'",
-					                    pos-in.begin()));
-				}
+inline uint64_t json_scanner::structurals(const json_masks& m) {
+	// characters after an odd number of backslashes: runs of backslashes that
+	// start on an odd bit carry into the bit after their end when added
+	const uint64_t even = 0x5555555555555555ULL;
+	uint64_t backslash = m.backslash & ~escaped;
+	uint64_t follows = backslash << 1 | escaped;
+	uint64_t odd_starts = backslash & ~even & ~follows;
+	uint64_t even_starts = odd_starts + backslash;
+	escaped = even_starts < odd_starts;
+	uint64_t esc = (even ^ (even_starts << 1)) & follows;
+
+	// inside strings: from an opening quote up to the character before the
+	// closing one, by a prefix xor of the unescaped quotes
+	uint64_t quote = m.quote & ~esc;
+	uint64_t s = quote;
+	s ^= s << 1; s ^= s << 2; s ^= s << 4;
+	s ^= s << 8; s ^= s << 16; s ^= s << 32;
+	s ^= in_string;
+	in_string = (uint64_t)((int64_t)s >> 63);
+
+	// first characters of other tokens
+	uint64_t other = ~(m.op | m.space | quote);
+	uint64_t follows_other = other << 1 | token;
+	token = other >> 63;
+	uint64_t starts = m.op | ((other | quote) & ~follows_other);
+
+	return starts & ~(s ^ quote);  // not inside strings, but opening quotes
+}
 
-				wchar_t wc[2];
-				wc[0] = hex;
-				wc[1] = 0;
-				char mb[17];
-				mb[16] = 0;
-				i = wcstombs(mb,wc,16);
-				if (i==(size_t)-1 || i>16) {
-
-					//fprintf(stderr, "%ld: JSON could not convert wide char (ignoring): %lX\n", pos-in.begin(), hex);
-
-					//throw runtime_error(json_fmt("%d: JSON could not convert wide char (code %X)",
-					//                        pos-in.begin(), hex));
-
-					//str->push_back(' ');
-					//delete str; str = 0;
-				} else if (i) {
-					for (size_t j = 0 ; j < i ; ++j)
-						str->push_back(mb[j]);
-					//str->append(mb,i);
-				}
-				} break;
-			default:
-				delete str; str = 0;
-				throw runtime_error(json_fmt("%d: JSON syntax error: invalid backslash escape",pos-in.begin()));
-			}
-			state=12;
-			break;
+static inline unsigned json_popcount(uint64_t x) {
+#ifdef __GNUC__
+	return __builtin_popcountll(x);
+#else
+	unsigned n = 0;
+	for (; x ; x &= x-1) ++n;
+	return n;
+#endif
+}
 
-		//
-		// ARRAY
-		//
-		case 15:  // after array start
-			switch (*pos) {
-			case ' ': case '\t': case '\r': case '\n':
-				break;
-			case ']':
-				//state=16;
-				++pos;
-				goto accept_array;
-			default:
-				array->push_back(JSON());
-				pos = json_decode(in, pos, array->back())-1;
-				state=17;
-			}
-			break;
-		//case 16:  // after array end
-		//	goto accept_array;
-		case 17:  // after array element
-			switch (*pos) {
-			case ' ': case '\t': case '\r': case '\n':
-				break;
-			case ',':
-				state=18;
-				break;
-			case ']':
-				//state=16;
-				++pos;
-				goto accept_array;
-			default:
-				throw runtime_error(json_fmt("%d: JSON syntax error: expected ',' or ']' after array element",pos-in.begin()));
-			}
-			break;
-		case 18:  // after comma
-			array->push_back(JSON());
-			pos = json_decode(in, pos, array->back())-1;
-			state=17;
-			break;
+json_index::json_index(const char *s, size_t n, size_t from)
+	: s(s), n(n), indexed(from), classify(json_best_classifier()), v(small), base(from), k(0), size(0) {
+	size_t len = n-from < (size_t)WINDOW ? (n-from+63) & ~(size_t)63 : (size_t)WINDOW;  // whole blocks
+	if (len > SMALL)
+		v = new uint32_t[len];
+}
+void json_index::fill() {
+	base = indexed;
+	k = size = 0;
+	size_t len = n-base < (size_t)WINDOW ? n-base : (size_t)WINDOW;
+	for (size_t i = 0 ; i < len ; i += 64) {
+		const char *b = s+base+i;
+		char tail[64];
+		if (len-i < 64) {
+			memset(tail, ' ', 64);
+			memcpy(tail, b, len-i);
+			b = tail;
+		}
 
-		//
-		// OBJECT
-		//
-		case 19:  // after object begin
-			switch (*pos) {
-			case ' ': case '\t': case '\r': case '\n':
-				break;
-			case '}':
-				//state=20;
-				++pos;
-				goto accept_object;
-			case '"':
-				pos = json_decode(in, pos, key)-1;
-				//if (key.type()!=JSON_STRING)
-				//	throw runtime_error(json_fmt("%d: JSON key not string",pos-in.begin()));
-				state=21;
-				break;
-			default:
-				throw runtime_error(json_fmt("%d: JSON syntax error: expected '}' or '\"' after object start",pos-in.begin()));
-			}
-			break;
-		//case 20:  // after object end
-		//	goto accept_object;
-		case 21:  // after key
-			switch (*pos) {
-			case ' ': case '\t': case '\r': case '\n':
-				break;
-			case ':':
-				state=22;
-				break;
-			default:
-				throw runtime_error(json_fmt("%d: JSON syntax error: expected ':' after object key",pos-in.begin()));
-			}
-			break;
-		case 22:
-			pos = json_decode(in, pos, (*object)[key.string()])-1;
-			state=23;
-			break;
-		case 23:  // after value
-			switch (*pos) {
-			case ' ': case '\t': case '\r': case '\n':
-				break;
-			case ',':
-				state=24;
-				break;
-			case '}':
-				//state=20;
-				++pos;
-				goto accept_object;
-			default:
-				throw runtime_error(json_fmt("%d: JSON syntax error: expected ',' or '}' after object key-value pair",pos-in.begin()));
-			}
-			break;
-		case 24:  // after comma
-			switch (*pos) {
-			case ' ': case '\t': case '\r': case '\n':
-				break;
-			case '"':
-				pos = json_decode(in, pos, key)-1;
-				//if (key.type()!=JSON_STRING)
-				//	throw runtime_error(json_fmt("%d: JSON key not string",pos-in.begin()));
-				state=21;
-				break;
-			default:
-				throw runtime_error(json_fmt("%d: JSON syntax error: expected '\"' after comma in object",pos-in.begin()));
+		json_masks m;
+		classify(b, m);
+		uint64_t bits = scanner.structurals(m);
+
+		// write 8 positions at a time whether there are that many or not, to
+		// keep the loop free of unpredictable branches; extra ones are garbage
+		// (the window leaves room for them: there are at most 64 per block)
+		unsigned count = json_popcount(bits);
+		uint32_t *o = v+size;
+		for (unsigned j = 0 ; j < count ; j += 8) {
+			for (unsigned l = 0 ; l < 8 ; ++l) {
+				o[j+l] = (uint32_t)(i + json_ctz(bits | (uint64_t)1<<63));
+				bits &= bits-1;
 			}
-			break;
 		}
+		size += count;
 	}
+	indexed += len;
+}
 
-	switch (state) {
-
-	accept_null: case 1:
-		out.set(0);
-		break;
-
-	accept_true: case 2:
-		out = true;
-		break;
 
-	accept_false: case 3:
-		out = false;
-		break;
+//
+// number parsing: the decimal digits are read into a 64-bit integer, which
+// is scaled exactly when it and the power of ten fit in a double (Clinger),
+// and otherwise with a 128-bit power of five (Eisel-Lemire); what neither
+// can round correctly, which is rare, goes to strtod()
+//
+static const double json_pow10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static const uint64_t json_pow5[][2] = {  // 5^q, q = -342...308, as the 128 leading bits
+	{0xeef453d6923bd65a,0x113faa2906a13b3f}, {0x9558b4661b6565f8,0x4ac7ca59a424c507},
+	{0xbaaee17fa23ebf76,0x5d79bcf00d2df649}, {0xe95a99df8ace6f53,0xf4d82c2c107973dc},
+	{0x91d8a02bb6c10594,0x79071b9b8a4be869}, {0xb64ec836a47146f9,0x9748e2826cdee284},
+	{0xe3e27a444d8d98b7,0xfd1b1b2308169b25}, {0x8e6d8c6ab0787f72,0xfe30f0f5e50e20f7},
+	{0xb208ef855c969f4f,0xbdbd2d335e51a935}, {0xde8b2b66b3bc4723,0xad2c788035e61382},
+	{0x8b16fb203055ac76,0x4c3bcb5021afcc31}, {0xaddcb9e83c6b1793,0xdf4abe242a1bbf3d},
+	{0xd953e8624b85dd78,0xd71d6dad34a2af0d}, {0x87d4713d6f33aa6b,0x8672648c40e5ad68},
+	{0xa9c98d8ccb009506,0x680efdaf511f18c2}, {0xd43bf0effdc0ba48,0x0212bd1b2566def2},
+	{0x84a57695fe98746d,0x014bb630f7604b57}, {0xa5ced43b7e3e9188,0x419ea3bd35385e2d},
+	{0xcf42894a5dce35ea,0x52064cac828675b9}, {0x818995ce7aa0e1b2,0x7343efebd1940993},
+	{0xa1ebfb4219491a1f,0x1014ebe6c5f90bf8}, {0xca66fa129f9b60a6,0xd41a26e077774ef6},
+	{0xfd00b897478238d0,0x8920b098955522b4}, {0x9e20735e8cb16382,0x55b46e5f5d5535b0},
+	{0xc5a890362fddbc62,0xeb2189f734aa831d}, {0xf712b443bbd52b7b,0xa5e9ec7501d523e4},
+	{0x9a6bb0aa55653b2d,0x47b233c92125366e}, {0xc1069cd4eabe89f8,0x999ec0bb696e840a},
+	{0xf148440a256e2c76,0xc00670ea43ca250d}, {0x96cd2a865764dbca,0x380406926a5e5728},
+	{0xbc807527ed3e12bc,0xc605083704f5ecf2}, {0xeba09271e88d976b,0xf7864a44c633682e},
+	{0x93445b8731587ea3,0x7ab3ee6afbe0211d}, {0xb8157268fdae9e4c,0x5960ea05bad82964},
+	{0xe61acf033d1a45df,0x6fb92487298e33bd}, {0x8fd0c16206306bab,0xa5d3b6d479f8e056},
+	{0xb3c4f1ba87bc8696,0x8f48a4899877186c}, {0xe0b62e2929aba83c,0x331acdabfe94de87},
+	{0x8c71dcd9ba0b4925,0x9ff0c08b7f1d0b14}, {0xaf8e5410288e1b6f,0x07ecf0ae5ee44dd9},
+	{0xdb71e91432b1a24a,0xc9e82cd9f69d6150}, {0x892731ac9faf056e,0xbe311c083a225cd2},
+	{0xab70fe17c79ac6ca,0x6dbd630a48aaf406}, {0xd64d3d9db981787d,0x092cbbccdad5b108},
+	{0x85f0468293f0eb4e,0x25bbf56008c58ea5}, {0xa76c582338ed2621,0xaf2af2b80af6f24e},
+	{0xd1476e2c07286faa,0x1af5af660db4aee1}, {0x82cca4db847945ca,0x50d98d9fc890ed4d},
+	{0xa37fce126597973c,0xe50ff107bab528a0}, {0xcc5fc196fefd7d0c,0x1e53ed49a96272c8},
+	{0xff77b1fcbebcdc4f,0x25e8e89c13bb0f7a}, {0x9faacf3df73609b1,0x77b191618c54e9ac},
+	{0xc795830d75038c1d,0xd59df5b9ef6a2417}, {0xf97ae3d0d2446f25,0x4b0573286b44ad1d},
+	{0x9becce62836ac577,0x4ee367f9430aec32}, {0xc2e801fb244576d5,0x229c41f793cda73f},
+	{0xf3a20279ed56d48a,0x6b43527578c1110f}, {0x9845418c345644d6,0x830a13896b78aaa9},
+	{0xbe5691ef416bd60c,0x23cc986bc656d553}, {0xedec366b11c6cb8f,0x2cbfbe86b7ec8aa8},
+	{0x94b3a202eb1c3f39,0x7bf7d71432f3d6a9}, {0xb9e08a83a5e34f07,0xdaf5ccd93fb0cc53},
+	{0xe858ad248f5c22c9,0xd1b3400f8f9cff68}, {0x91376c36d99995be,0x23100809b9c21fa1},
+	{0xb58547448ffffb2d,0xabd40a0c2832a78a}, {0xe2e69915b3fff9f9,0x16c90c8f323f516c},
+	{0x8dd01fad907ffc3b,0xae3da7d97f6792e3}, {0xb1442798f49ffb4a,0x99cd11cfdf41779c},
+	{0xdd95317f31c7fa1d,0x40405643d711d583}, {0x8a7d3eef7f1cfc52,0x482835ea666b2572},
+	{0xad1c8eab5ee43b66,0xda3243650005eecf}, {0xd863b256369d4a40,0x90bed43e40076a82},
+	{0x873e4f75e2224e68,0x5a7744a6e804a291}, {0xa90de3535aaae202,0x711515d0a205cb36},
+	{0xd3515c2831559a83,0x0d5a5b44ca873e03}, {0x8412d9991ed58091,0xe858790afe9486c2},
+	{0xa5178fff668ae0b6,0x626e974dbe39a872}, {0xce5d73ff402d98e3,0xfb0a3d212dc8128f},
+	{0x80fa687f881c7f8e,0x7ce66634bc9d0b99}, {0xa139029f6a239f72,0x1c1fffc1ebc44e80},
+	{0xc987434744ac874e,0xa327ffb266b56220}, {0xfbe9141915d7a922,0x4bf1ff9f0062baa8},
+	{0x9d71ac8fada6c9b5,0x6f773fc3603db4a9}, {0xc4ce17b399107c22,0xcb550fb4384d21d3},
+	{0xf6019da07f549b2b,0x7e2a53a146606a48}, {0x99c102844f94e0fb,0x2eda7444cbfc426d},
+	{0xc0314325637a1939,0xfa911155fefb5308}, {0xf03d93eebc589f88,0x793555ab7eba27ca},
+	{0x96267c7535b763b5,0x4bc1558b2f3458de}, {0xbbb01b9283253ca2,0x9eb1aaedfb016f16},
+	{0xea9c227723ee8bcb,0x465e15a979c1cadc}, {0x92a1958a7675175f,0x0bfacd89ec191ec9},
+	{0xb749faed14125d36,0xcef980ec671f667b}, {0xe51c79a85916f484,0x82b7e12780e7401a},
+	{0x8f31cc0937ae58d2,0xd1b2ecb8b0908810}, {0xb2fe3f0b8599ef07,0x861fa7e6dcb4aa15},
+	{0xdfbdcece67006ac9,0x67a791e093e1d49a}, {0x8bd6a141006042bd,0xe0c8bb2c5c6d24e0},
+	{0xaecc49914078536d,0x58fae9f773886e18}, {0xda7f5bf590966848,0xaf39a475506a899e},
+	{0x888f99797a5e012d,0x6d8406c952429603}, {0xaab37fd7d8f58178,0xc8e5087ba6d33b83},
+	{0xd5605fcdcf32e1d6,0xfb1e4a9a90880a64}, {0x855c3be0a17fcd26,0x5cf2eea09a55067f},
+	{0xa6b34ad8c9dfc06f,0xf42faa48c0ea481e}, {0xd0601d8efc57b08b,0xf13b94daf124da26},
+	{0x823c12795db6ce57,0x76c53d08d6b70858}, {0xa2cb1717b52481ed,0x54768c4b0c64ca6e},
+	{0xcb7ddcdda26da268,0xa9942f5dcf7dfd09}, {0xfe5d54150b090b02,0xd3f93b35435d7c4c},
+	{0x9efa548d26e5a6e1,0xc47bc5014a1a6daf}, {0xc6b8e9b0709f109a,0x359ab6419ca1091b},
+	{0xf867241c8cc6d4c0,0xc30163d203c94b62}, {0x9b407691d7fc44f8,0x79e0de63425dcf1d},
+	{0xc21094364dfb5636,0x985915fc12f542e4}, {0xf294b943e17a2bc4,0x3e6f5b7b17b2939d},
+	{0x979cf3ca6cec5b5a,0xa705992ceecf9c42}, {0xbd8430bd08277231,0x50c6ff782a838353},
+	{0xece53cec4a314ebd,0xa4f8bf5635246428}, {0x940f4613ae5ed136,0x871b7795e136be99},
+	{0xb913179899f68584,0x28e2557b59846e3f}, {0xe757dd7ec07426e5,0x331aeada2fe589cf},
+	{0x9096ea6f3848984f,0x3ff0d2c85def7621}, {0xb4bca50b065abe63,0x0fed077a756b53a9},
+	{0xe1ebce4dc7f16dfb,0xd3e8495912c62894}, {0x8d3360f09cf6e4bd,0x64712dd7abbbd95c},
+	{0xb080392cc4349dec,0xbd8d794d96aacfb3}, {0xdca04777f541c567,0xecf0d7a0fc5583a0},
+	{0x89e42caaf9491b60,0xf41686c49db57244}, {0xac5d37d5b79b6239,0x311c2875c522ced5},
+	{0xd77485cb25823ac7,0x7d633293366b828b}, {0x86a8d39ef77164bc,0xae5dff9c02033197},
+	{0xa8530886b54dbdeb,0xd9f57f830283fdfc}, {0xd267caa862a12d66,0xd072df63c324fd7b},
+	{0x8380dea93da4bc60,0x4247cb9e59f71e6d}, {0xa46116538d0deb78,0x52d9be85f074e608},
+	{0xcd795be870516656,0x67902e276c921f8b}, {0x806bd9714632dff6,0x00ba1cd8a3db53b6},
+	{0xa086cfcd97bf97f3,0x80e8a40eccd228a4}, {0xc8a883c0fdaf7df0,0x6122cd128006b2cd},
+	{0xfad2a4b13d1b5d6c,0x796b805720085f81}, {0x9cc3a6eec6311a63,0xcbe3303674053bb0},
+	{0xc3f490aa77bd60fc,0xbedbfc4411068a9c}, {0xf4f1b4d515acb93b,0xee92fb5515482d44},
+	{0x991711052d8bf3c5,0x751bdd152d4d1c4a}, {0xbf5cd54678eef0b6,0xd262d45a78a0635d},
+	{0xef340a98172aace4,0x86fb897116c87c34}, {0x9580869f0e7aac0e,0xd45d35e6ae3d4da0},
+	{0xbae0a846d2195712,0x8974836059cca109}, {0xe998d258869facd7,0x2bd1a438703fc94b},
+	{0x91ff83775423cc06,0x7b6306a34627ddcf}, {0xb67f6455292cbf08,0x1a3bc84c17b1d542},
+	{0xe41f3d6a7377eeca,0x20caba5f1d9e4a93}, {0x8e938662882af53e,0x547eb47b7282ee9c},
+	{0xb23867fb2a35b28d,0xe99e619a4f23aa43}, {0xdec681f9f4c31f31,0x6405fa00e2ec94d4},
+	{0x8b3c113c38f9f37e,0xde83bc408dd3dd04}, {0xae0b158b4738705e,0x9624ab50b148d445},
+	{0xd98ddaee19068c76,0x3badd624dd9b0957}, {0x87f8a8d4cfa417c9,0xe54ca5d70a80e5d6},
+	{0xa9f6d30a038d1dbc,0x5e9fcf4ccd211f4c}, {0xd47487cc8470652b,0x7647c3200069671f},
+	{0x84c8d4dfd2c63f3b,0x29ecd9f40041e073}, {0xa5fb0a17c777cf09,0xf468107100525890},
+	{0xcf79cc9db955c2cc,0x7182148d4066eeb4}, {0x81ac1fe293d599bf,0xc6f14cd848405530},
+	{0xa21727db38cb002f,0xb8ada00e5a506a7c}, {0xca9cf1d206fdc03b,0xa6d90811f0e4851c},
+	{0xfd442e4688bd304a,0x908f4a166d1da663}, {0x9e4a9cec15763e2e,0x9a598e4e043287fe},
+	{0xc5dd44271ad3cdba,0x40eff1e1853f29fd}, {0xf7549530e188c128,0xd12bee59e68ef47c},
+	{0x9a94dd3e8cf578b9,0x82bb74f8301958ce}, {0xc13a148e3032d6e7,0xe36a52363c1faf01},
+	{0xf18899b1bc3f8ca1,0xdc44e6c3cb279ac1}, {0x96f5600f15a7b7e5,0x29ab103a5ef8c0b9},
+	{0xbcb2b812db11a5de,0x7415d448f6b6f0e7}, {0xebdf661791d60f56,0x111b495b3464ad21},
+	{0x936b9fcebb25c995,0xcab10dd900beec34}, {0xb84687c269ef3bfb,0x3d5d514f40eea742},
+	{0xe65829b3046b0afa,0x0cb4a5a3112a5112}, {0x8ff71a0fe2c2e6dc,0x47f0e785eaba72ab},
+	{0xb3f4e093db73a093,0x59ed216765690f56}, {0xe0f218b8d25088b8,0x306869c13ec3532c},
+	{0x8c974f7383725573,0x1e414218c73a13fb}, {0xafbd2350644eeacf,0xe5d1929ef90898fa},
+	{0xdbac6c247d62a583,0xdf45f746b74abf39}, {0x894bc396ce5da772,0x6b8bba8c328eb783},
+	{0xab9eb47c81f5114f,0x066ea92f3f326564}, {0xd686619ba27255a2,0xc80a537b0efefebd},
+	{0x8613fd0145877585,0xbd06742ce95f5f36}, {0xa798fc4196e952e7,0x2c48113823b73704},
+	{0xd17f3b51fca3a7a0,0xf75a15862ca504c5}, {0x82ef85133de648c4,0x9a984d73dbe722fb},
+	{0xa3ab66580d5fdaf5,0xc13e60d0d2e0ebba}, {0xcc963fee10b7d1b3,0x318df905079926a8},
+	{0xffbbcfe994e5c61f,0xfdf17746497f7052}, {0x9fd561f1fd0f9bd3,0xfeb6ea8bedefa633},
+	{0xc7caba6e7c5382c8,0xfe64a52ee96b8fc0}, {0xf9bd690a1b68637b,0x3dfdce7aa3c673b0},
+	{0x9c1661a651213e2d,0x06bea10ca65c084e}, {0xc31bfa0fe5698db8,0x486e494fcff30a62},
+	{0xf3e2f893dec3f126,0x5a89dba3c3efccfa}, {0x986ddb5c6b3a76b7,0xf89629465a75e01c},
+	{0xbe89523386091465,0xf6bbb397f1135823}, {0xee2ba6c0678b597f,0x746aa07ded582e2c},
+	{0x94db483840b717ef,0xa8c2a44eb4571cdc}, {0xba121a4650e4ddeb,0x92f34d62616ce413},
+	{0xe896a0d7e51e1566,0x77b020baf9c81d17}, {0x915e2486ef32cd60,0x0ace1474dc1d122e},
+	{0xb5b5ada8aaff80b8,0x0d819992132456ba}, {0xe3231912d5bf60e6,0x10e1fff697ed6c69},
+	{0x8df5efabc5979c8f,0xca8d3ffa1ef463c1}, {0xb1736b96b6fd83b3,0xbd308ff8a6b17cb2},
+	{0xddd0467c64bce4a0,0xac7cb3f6d05ddbde}, {0x8aa22c0dbef60ee4,0x6bcdf07a423aa96b},
+	{0xad4ab7112eb3929d,0x86c16c98d2c953c6}, {0xd89d64d57a607744,0xe871c7bf077ba8b7},
+	{0x87625f056c7c4a8b,0x11471cd764ad4972}, {0xa93af6c6c79b5d2d,0xd598e40d3dd89bcf},
+	{0xd389b47879823479,0x4aff1d108d4ec2c3}, {0x843610cb4bf160cb,0xcedf722a585139ba},
+	{0xa54394fe1eedb8fe,0xc2974eb4ee658828}, {0xce947a3da6a9273e,0x733d226229feea32},
+	{0x811ccc668829b887,0x0806357d5a3f525f}, {0xa163ff802a3426a8,0xca07c2dcb0cf26f7},
+	{0xc9bcff6034c13052,0xfc89b393dd02f0b5}, {0xfc2c3f3841f17c67,0xbbac2078d443ace2},
+	{0x9d9ba7832936edc0,0xd54b944b84aa4c0d}, {0xc5029163f384a931,0x0a9e795e65d4df11},
+	{0xf64335bcf065d37d,0x4d4617b5ff4a16d5}, {0x99ea0196163fa42e,0x504bced1bf8e4e45},
+	{0xc06481fb9bcf8d39,0xe45ec2862f71e1d6}, {0xf07da27a82c37088,0x5d767327bb4e5a4c},
+	{0x964e858c91ba2655,0x3a6a07f8d510f86f}, {0xbbe226efb628afea,0x890489f70a55368b},
+	{0xeadab0aba3b2dbe5,0x2b45ac74ccea842e}, {0x92c8ae6b464fc96f,0x3b0b8bc90012929d},
+	{0xb77ada0617e3bbcb,0x09ce6ebb40173744}, {0xe55990879ddcaabd,0xcc420a6a101d0515},
+	{0x8f57fa54c2a9eab6,0x9fa946824a12232d}, {0xb32df8e9f3546564,0x47939822dc96abf9},
+	{0xdff9772470297ebd,0x59787e2b93bc56f7}, {0x8bfbea76c619ef36,0x57eb4edb3c55b65a},
+	{0xaefae51477a06b03,0xede622920b6b23f1}, {0xdab99e59958885c4,0xe95fab368e45eced},
+	{0x88b402f7fd75539b,0x11dbcb0218ebb414}, {0xaae103b5fcd2a881,0xd652bdc29f26a119},
+	{0xd59944a37c0752a2,0x4be76d3346f0495f}, {0x857fcae62d8493a5,0x6f70a4400c562ddb},
+	{0xa6dfbd9fb8e5b88e,0xcb4ccd500f6bb952}, {0xd097ad07a71f26b2,0x7e2000a41346a7a7},
+	{0x825ecc24c873782f,0x8ed400668c0c28c8}, {0xa2f67f2dfa90563b,0x728900802f0f32fa},
+	{0xcbb41ef979346bca,0x4f2b40a03ad2ffb9}, {0xfea126b7d78186bc,0xe2f610c84987bfa8},
+	{0x9f24b832e6b0f436,0x0dd9ca7d2df4d7c9}, {0xc6ede63fa05d3143,0x91503d1c79720dbb},
+	{0xf8a95fcf88747d94,0x75a44c6397ce912a}, {0x9b69dbe1b548ce7c,0xc986afbe3ee11aba},
+	{0xc24452da229b021b,0xfbe85badce996168}, {0xf2d56790ab41c2a2,0xfae27299423fb9c3},
+	{0x97c560ba6b0919a5,0xdccd879fc967d41a}, {0xbdb6b8e905cb600f,0x5400e987bbc1c920},
+	{0xed246723473e3813,0x290123e9aab23b68}, {0x9436c0760c86e30b,0xf9a0b6720aaf6521},
+	{0xb94470938fa89bce,0xf808e40e8d5b3e69}, {0xe7958cb87392c2c2,0xb60b1d1230b20e04},
+	{0x90bd77f3483bb9b9,0xb1c6f22b5e6f48c2}, {0xb4ecd5f01a4aa828,0x1e38aeb6360b1af3},
+	{0xe2280b6c20dd5232,0x25c6da63c38de1b0}, {0x8d590723948a535f,0x579c487e5a38ad0e},
+	{0xb0af48ec79ace837,0x2d835a9df0c6d851}, {0xdcdb1b2798182244,0xf8e431456cf88e65},
+	{0x8a08f0f8bf0f156b,0x1b8e9ecb641b58ff}, {0xac8b2d36eed2dac5,0xe272467e3d222f3f},
+	{0xd7adf884aa879177,0x5b0ed81dcc6abb0f}, {0x86ccbb52ea94baea,0x98e947129fc2b4e9},
+	{0xa87fea27a539e9a5,0x3f2398d747b36224}, {0xd29fe4b18e88640e,0x8eec7f0d19a03aad},
+	{0x83a3eeeef9153e89,0x1953cf68300424ac}, {0xa48ceaaab75a8e2b,0x5fa8c3423c052dd7},
+	{0xcdb02555653131b6,0x3792f412cb06794d}, {0x808e17555f3ebf11,0xe2bbd88bbee40bd0},
+	{0xa0b19d2ab70e6ed6,0x5b6aceaeae9d0ec4}, {0xc8de047564d20a8b,0xf245825a5a445275},
+	{0xfb158592be068d2e,0xeed6e2f0f0d56712}, {0x9ced737bb6c4183d,0x55464dd69685606b},
+	{0xc428d05aa4751e4c,0xaa97e14c3c26b886}, {0xf53304714d9265df,0xd53dd99f4b3066a8},
+	{0x993fe2c6d07b7fab,0xe546a8038efe4029}, {0xbf8fdb78849a5f96,0xde98520472bdd033},
+	{0xef73d256a5c0f77c,0x963e66858f6d4440}, {0x95a8637627989aad,0xdde7001379a44aa8},
+	{0xbb127c53b17ec159,0x5560c018580d5d52}, {0xe9d71b689dde71af,0xaab8f01e6e10b4a6},
+	{0x9226712162ab070d,0xcab3961304ca70e8}, {0xb6b00d69bb55c8d1,0x3d607b97c5fd0d22},
+	{0xe45c10c42a2b3b05,0x8cb89a7db77c506a}, {0x8eb98a7a9a5b04e3,0x77f3608e92adb242},
+	{0xb267ed1940f1c61c,0x55f038b237591ed3}, {0xdf01e85f912e37a3,0x6b6c46dec52f6688},
+	{0x8b61313bbabce2c6,0x2323ac4b3b3da015}, {0xae397d8aa96c1b77,0xabec975e0a0d081a},
+	{0xd9c7dced53c72255,0x96e7bd358c904a21}, {0x881cea14545c7575,0x7e50d64177da2e54},
+	{0xaa242499697392d2,0xdde50bd1d5d0b9e9}, {0xd4ad2dbfc3d07787,0x955e4ec64b44e864},
+	{0x84ec3c97da624ab4,0xbd5af13bef0b113e}, {0xa6274bbdd0fadd61,0xecb1ad8aeacdd58e},
+	{0xcfb11ead453994ba,0x67de18eda5814af2}, {0x81ceb32c4b43fcf4,0x80eacf948770ced7},
+	{0xa2425ff75e14fc31,0xa1258379a94d028d}, {0xcad2f7f5359a3b3e,0x096ee45813a04330},
+	{0xfd87b5f28300ca0d,0x8bca9d6e188853fc}, {0x9e74d1b791e07e48,0x775ea264cf55347e},
+	{0xc612062576589dda,0x95364afe032a819e}, {0xf79687aed3eec551,0x3a83ddbd83f52205},
+	{0x9abe14cd44753b52,0xc4926a9672793543}, {0xc16d9a0095928a27,0x75b7053c0f178294},
+	{0xf1c90080baf72cb1,0x5324c68b12dd6339}, {0x971da05074da7bee,0xd3f6fc16ebca5e04},
+	{0xbce5086492111aea,0x88f4bb1ca6bcf585}, {0xec1e4a7db69561a5,0x2b31e9e3d06c32e6},
+	{0x9392ee8e921d5d07,0x3aff322e62439fd0}, {0xb877aa3236a4b449,0x09befeb9fad487c3},
+	{0xe69594bec44de15b,0x4c2ebe687989a9b4}, {0x901d7cf73ab0acd9,0x0f9d37014bf60a11},
+	{0xb424dc35095cd80f,0x538484c19ef38c95}, {0xe12e13424bb40e13,0x2865a5f206b06fba},
+	{0x8cbccc096f5088cb,0xf93f87b7442e45d4}, {0xafebff0bcb24aafe,0xf78f69a51539d749},
+	{0xdbe6fecebdedd5be,0xb573440e5a884d1c}, {0x89705f4136b4a597,0x31680a88f8953031},
+	{0xabcc77118461cefc,0xfdc20d2b36ba7c3e}, {0xd6bf94d5e57a42bc,0x3d32907604691b4d},
+	{0x8637bd05af6c69b5,0xa63f9a49c2c1b110}, {0xa7c5ac471b478423,0x0fcf80dc33721d54},
+	{0xd1b71758e219652b,0xd3c36113404ea4a9}, {0x83126e978d4fdf3b,0x645a1cac083126ea},
+	{0xa3d70a3d70a3d70a,0x3d70a3d70a3d70a4}, {0xcccccccccccccccc,0xcccccccccccccccd},
+	{0x8000000000000000,0x0000000000000000}, {0xa000000000000000,0x0000000000000000},
+	{0xc800000000000000,0x0000000000000000}, {0xfa00000000000000,0x0000000000000000},
+	{0x9c40000000000000,0x0000000000000000}, {0xc350000000000000,0x0000000000000000},
+	{0xf424000000000000,0x0000000000000000}, {0x9896800000000000,0x0000000000000000},
+	{0xbebc200000000000,0x0000000000000000}, {0xee6b280000000000,0x0000000000000000},
+	{0x9502f90000000000,0x0000000000000000}, {0xba43b74000000000,0x0000000000000000},
+	{0xe8d4a51000000000,0x0000000000000000}, {0x9184e72a00000000,0x0000000000000000},
+	{0xb5e620f480000000,0x0000000000000000}, {0xe35fa931a0000000,0x0000000000000000},
+	{0x8e1bc9bf04000000,0x0000000000000000}, {0xb1a2bc2ec5000000,0x0000000000000000},
+	{0xde0b6b3a76400000,0x0000000000000000}, {0x8ac7230489e80000,0x0000000000000000},
+	{0xad78ebc5ac620000,0x0000000000000000}, {0xd8d726b7177a8000,0x0000000000000000},
+	{0x878678326eac9000,0x0000000000000000}, {0xa968163f0a57b400,0x0000000000000000},
+	{0xd3c21bcecceda100,0x0000000000000000}, {0x84595161401484a0,0x0000000000000000},
+	{0xa56fa5b99019a5c8,0x0000000000000000}, {0xcecb8f27f4200f3a,0x0000000000000000},
+	{0x813f3978f8940984,0x4000000000000000}, {0xa18f07d736b90be5,0x5000000000000000},
+	{0xc9f2c9cd04674ede,0xa400000000000000}, {0xfc6f7c4045812296,0x4d00000000000000},
+	{0x9dc5ada82b70b59d,0xf020000000000000}, {0xc5371912364ce305,0x6c28000000000000},
+	{0xf684df56c3e01bc6,0xc732000000000000}, {0x9a130b963a6c115c,0x3c7f400000000000},
+	{0xc097ce7bc90715b3,0x4b9f100000000000}, {0xf0bdc21abb48db20,0x1e86d40000000000},
+	{0x96769950b50d88f4,0x1314448000000000}, {0xbc143fa4e250eb31,0x17d955a000000000},
+	{0xeb194f8e1ae525fd,0x5dcfab0800000000}, {0x92efd1b8d0cf37be,0x5aa1cae500000000},
+	{0xb7abc627050305ad,0xf14a3d9e40000000}, {0xe596b7b0c643c719,0x6d9ccd05d0000000},
+	{0x8f7e32ce7bea5c6f,0xe4820023a2000000}, {0xb35dbf821ae4f38b,0xdda2802c8a800000},
+	{0xe0352f62a19e306e,0xd50b2037ad200000}, {0x8c213d9da502de45,0x4526f422cc340000},
+	{0xaf298d050e4395d6,0x9670b12b7f410000}, {0xdaf3f04651d47b4c,0x3c0cdd765f114000},
+	{0x88d8762bf324cd0f,0xa5880a69fb6ac800}, {0xab0e93b6efee0053,0x8eea0d047a457a00},
+	{0xd5d238a4abe98068,0x72a4904598d6d880}, {0x85a36366eb71f041,0x47a6da2b7f864750},
+	{0xa70c3c40a64e6c51,0x999090b65f67d924}, {0xd0cf4b50cfe20765,0xfff4b4e3f741cf6d},
+	{0x82818f1281ed449f,0xbff8f10e7a8921a4}, {0xa321f2d7226895c7,0xaff72d52192b6a0d},
+	{0xcbea6f8ceb02bb39,0x9bf4f8a69f764490}, {0xfee50b7025c36a08,0x02f236d04753d5b4},
+	{0x9f4f2726179a2245,0x01d762422c946590}, {0xc722f0ef9d80aad6,0x424d3ad2b7b97ef5},
+	{0xf8ebad2b84e0d58b,0xd2e0898765a7deb2}, {0x9b934c3b330c8577,0x63cc55f49f88eb2f},
+	{0xc2781f49ffcfa6d5,0x3cbf6b71c76b25fb}, {0xf316271c7fc3908a,0x8bef464e3945ef7a},
+	{0x97edd871cfda3a56,0x97758bf0e3cbb5ac}, {0xbde94e8e43d0c8ec,0x3d52eeed1cbea317},
+	{0xed63a231d4c4fb27,0x4ca7aaa863ee4bdd}, {0x945e455f24fb1cf8,0x8fe8caa93e74ef6a},
+	{0xb975d6b6ee39e436,0xb3e2fd538e122b44}, {0xe7d34c64a9c85d44,0x60dbbca87196b616},
+	{0x90e40fbeea1d3a4a,0xbc8955e946fe31cd}, {0xb51d13aea4a488dd,0x6babab6398bdbe41},
+	{0xe264589a4dcdab14,0xc696963c7eed2dd1}, {0x8d7eb76070a08aec,0xfc1e1de5cf543ca2},
+	{0xb0de65388cc8ada8,0x3b25a55f43294bcb}, {0xdd15fe86affad912,0x49ef0eb713f39ebe},
+	{0x8a2dbf142dfcc7ab,0x6e3569326c784337}, {0xacb92ed9397bf996,0x49c2c37f07965404},
+	{0xd7e77a8f87daf7fb,0xdc33745ec97be906}, {0x86f0ac99b4e8dafd,0x69a028bb3ded71a3},
+	{0xa8acd7c0222311bc,0xc40832ea0d68ce0c}, {0xd2d80db02aabd62b,0xf50a3fa490c30190},
+	{0x83c7088e1aab65db,0x792667c6da79e0fa}, {0xa4b8cab1a1563f52,0x577001b891185938},
+	{0xcde6fd5e09abcf26,0xed4c0226b55e6f86}, {0x80b05e5ac60b6178,0x544f8158315b05b4},
+	{0xa0dc75f1778e39d6,0x696361ae3db1c721}, {0xc913936dd571c84c,0x03bc3a19cd1e38e9},
+	{0xfb5878494ace3a5f,0x04ab48a04065c723}, {0x9d174b2dcec0e47b,0x62eb0d64283f9c76},
+	{0xc45d1df942711d9a,0x3ba5d0bd324f8394}, {0xf5746577930d6500,0xca8f44ec7ee36479},
+	{0x9968bf6abbe85f20,0x7e998b13cf4e1ecb}, {0xbfc2ef456ae276e8,0x9e3fedd8c321a67e},
+	{0xefb3ab16c59b14a2,0xc5cfe94ef3ea101e}, {0x95d04aee3b80ece5,0xbba1f1d158724a12},
+	{0xbb445da9ca61281f,0x2a8a6e45ae8edc97}, {0xea1575143cf97226,0xf52d09d71a3293bd},
+	{0x924d692ca61be758,0x593c2626705f9c56}, {0xb6e0c377cfa2e12e,0x6f8b2fb00c77836c},
+	{0xe498f455c38b997a,0x0b6dfb9c0f956447}, {0x8edf98b59a373fec,0x4724bd4189bd5eac},
+	{0xb2977ee300c50fe7,0x58edec91ec2cb657}, {0xdf3d5e9bc0f653e1,0x2f2967b66737e3ed},
+	{0x8b865b215899f46c,0xbd79e0d20082ee74}, {0xae67f1e9aec07187,0xecd8590680a3aa11},
+	{0xda01ee641a708de9,0xe80e6f4820cc9495}, {0x884134fe908658b2,0x3109058d147fdcdd},
+	{0xaa51823e34a7eede,0xbd4b46f0599fd415}, {0xd4e5e2cdc1d1ea96,0x6c9e18ac7007c91a},
+	{0x850fadc09923329e,0x03e2cf6bc604ddb0}, {0xa6539930bf6bff45,0x84db8346b786151c},
+	{0xcfe87f7cef46ff16,0xe612641865679a63}, {0x81f14fae158c5f6e,0x4fcb7e8f3f60c07e},
+	{0xa26da3999aef7749,0xe3be5e330f38f09d}, {0xcb090c8001ab551c,0x5cadf5bfd3072cc5},
+	{0xfdcb4fa002162a63,0x73d9732fc7c8f7f6}, {0x9e9f11c4014dda7e,0x2867e7fddcdd9afa},
+	{0xc646d63501a1511d,0xb281e1fd541501b8}, {0xf7d88bc24209a565,0x1f225a7ca91a4226},
+	{0x9ae757596946075f,0x3375788de9b06958}, {0xc1a12d2fc3978937,0x0052d6b1641c83ae},
+	{0xf209787bb47d6b84,0xc0678c5dbd23a49a}, {0x9745eb4d50ce6332,0xf840b7ba963646e0},
+	{0xbd176620a501fbff,0xb650e5a93bc3d898}, {0xec5d3fa8ce427aff,0xa3e51f138ab4cebe},
+	{0x93ba47c980e98cdf,0xc66f336c36b10137}, {0xb8a8d9bbe123f017,0xb80b0047445d4184},
+	{0xe6d3102ad96cec1d,0xa60dc059157491e5}, {0x9043ea1ac7e41392,0x87c89837ad68db2f},
+	{0xb454e4a179dd1877,0x29babe4598c311fb}, {0xe16a1dc9d8545e94,0xf4296dd6fef3d67a},
+	{0x8ce2529e2734bb1d,0x1899e4a65f58660c}, {0xb01ae745b101e9e4,0x5ec05dcff72e7f8f},
+	{0xdc21a1171d42645d,0x76707543f4fa1f73}, {0x899504ae72497eba,0x6a06494a791c53a8},
+	{0xabfa45da0edbde69,0x0487db9d17636892}, {0xd6f8d7509292d603,0x45a9d2845d3c42b6},
+	{0x865b86925b9bc5c2,0x0b8a2392ba45a9b2}, {0xa7f26836f282b732,0x8e6cac7768d7141e},
+	{0xd1ef0244af2364ff,0x3207d795430cd926}, {0x8335616aed761f1f,0x7f44e6bd49e807b8},
+	{0xa402b9c5a8d3a6e7,0x5f16206c9c6209a6}, {0xcd036837130890a1,0x36dba887c37a8c0f},
+	{0x802221226be55a64,0xc2494954da2c9789}, {0xa02aa96b06deb0fd,0xf2db9baa10b7bd6c},
+	{0xc83553c5c8965d3d,0x6f92829494e5acc7}, {0xfa42a8b73abbf48c,0xcb772339ba1f17f9},
+	{0x9c69a97284b578d7,0xff2a760414536efb}, {0xc38413cf25e2d70d,0xfef5138519684aba},
+	{0xf46518c2ef5b8cd1,0x7eb258665fc25d69}, {0x98bf2f79d5993802,0xef2f773ffbd97a61},
+	{0xbeeefb584aff8603,0xaafb550ffacfd8fa}, {0xeeaaba2e5dbf6784,0x95ba2a53f983cf38},
+	{0x952ab45cfa97a0b2,0xdd945a747bf26183}, {0xba756174393d88df,0x94f971119aeef9e4},
+	{0xe912b9d1478ceb17,0x7a37cd5601aab85d}, {0x91abb422ccb812ee,0xac62e055c10ab33a},
+	{0xb616a12b7fe617aa,0x577b986b314d6009}, {0xe39c49765fdf9d94,0xed5a7e85fda0b80b},
+	{0x8e41ade9fbebc27d,0x14588f13be847307}, {0xb1d219647ae6b31c,0x596eb2d8ae258fc8},
+	{0xde469fbd99a05fe3,0x6fca5f8ed9aef3bb}, {0x8aec23d680043bee,0x25de7bb9480d5854},
+	{0xada72ccc20054ae9,0xaf561aa79a10ae6a}, {0xd910f7ff28069da4,0x1b2ba1518094da04},
+	{0x87aa9aff79042286,0x90fb44d2f05d0842}, {0xa99541bf57452b28,0x353a1607ac744a53},
+	{0xd3fa922f2d1675f2,0x42889b8997915ce8}, {0x847c9b5d7c2e09b7,0x69956135febada11},
+	{0xa59bc234db398c25,0x43fab9837e699095}, {0xcf02b2c21207ef2e,0x94f967e45e03f4bb},
+	{0x8161afb94b44f57d,0x1d1be0eebac278f5}, {0xa1ba1ba79e1632dc,0x6462d92a69731732},
+	{0xca28a291859bbf93,0x7d7b8f7503cfdcfe}, {0xfcb2cb35e702af78,0x5cda735244c3d43e},
+	{0x9defbf01b061adab,0x3a0888136afa64a7}, {0xc56baec21c7a1916,0x088aaa1845b8fdd0},
+	{0xf6c69a72a3989f5b,0x8aad549e57273d45}, {0x9a3c2087a63f6399,0x36ac54e2f678864b},
+	{0xc0cb28a98fcf3c7f,0x84576a1bb416a7dd}, {0xf0fdf2d3f3c30b9f,0x656d44a2a11c51d5},
+	{0x969eb7c47859e743,0x9f644ae5a4b1b325}, {0xbc4665b596706114,0x873d5d9f0dde1fee},
+	{0xeb57ff22fc0c7959,0xa90cb506d155a7ea}, {0x9316ff75dd87cbd8,0x09a7f12442d588f2},
+	{0xb7dcbf5354e9bece,0x0c11ed6d538aeb2f}, {0xe5d3ef282a242e81,0x8f1668c8a86da5fa},
+	{0x8fa475791a569d10,0xf96e017d694487bc}, {0xb38d92d760ec4455,0x37c981dcc395a9ac},
+	{0xe070f78d3927556a,0x85bbe253f47b1417}, {0x8c469ab843b89562,0x93956d7478ccec8e},
+	{0xaf58416654a6babb,0x387ac8d1970027b2}, {0xdb2e51bfe9d0696a,0x06997b05fcc0319e},
+	{0x88fcf317f22241e2,0x441fece3bdf81f03}, {0xab3c2fddeeaad25a,0xd527e81cad7626c3},
+	{0xd60b3bd56a5586f1,0x8a71e223d8d3b074}, {0x85c7056562757456,0xf6872d5667844e49},
+	{0xa738c6bebb12d16c,0xb428f8ac016561db}, {0xd106f86e69d785c7,0xe13336d701beba52},
+	{0x82a45b450226b39c,0xecc0024661173473}, {0xa34d721642b06084,0x27f002d7f95d0190},
+	{0xcc20ce9bd35c78a5,0x31ec038df7b441f4}, {0xff290242c83396ce,0x7e67047175a15271},
+	{0x9f79a169bd203e41,0x0f0062c6e984d386}, {0xc75809c42c684dd1,0x52c07b78a3e60868},
+	{0xf92e0c3537826145,0xa7709a56ccdf8a82}, {0x9bbcc7a142b17ccb,0x88a66076400bb691},
+	{0xc2abf989935ddbfe,0x6acff893d00ea435}, {0xf356f7ebf83552fe,0x0583f6b8c4124d43},
+	{0x98165af37b2153de,0xc3727a337a8b704a}, {0xbe1bf1b059e9a8d6,0x744f18c0592e4c5c},
+	{0xeda2ee1c7064130c,0x1162def06f79df73}, {0x9485d4d1c63e8be7,0x8addcb5645ac2ba8},
+	{0xb9a74a0637ce2ee1,0x6d953e2bd7173692}, {0xe8111c87c5c1ba99,0xc8fa8db6ccdd0437},
+	{0x910ab1d4db9914a0,0x1d9c9892400a22a2}, {0xb54d5e4a127f59c8,0x2503beb6d00cab4b},
+	{0xe2a0b5dc971f303a,0x2e44ae64840fd61d}, {0x8da471a9de737e24,0x5ceaecfed289e5d2},
+	{0xb10d8e1456105dad,0x7425a83e872c5f47}, {0xdd50f1996b947518,0xd12f124e28f77719},
+	{0x8a5296ffe33cc92f,0x82bd6b70d99aaa6f}, {0xace73cbfdc0bfb7b,0x636cc64d1001550b},
+	{0xd8210befd30efa5a,0x3c47f7e05401aa4e}, {0x8714a775e3e95c78,0x65acfaec34810a71},
+	{0xa8d9d1535ce3b396,0x7f1839a741a14d0d}, {0xd31045a8341ca07c,0x1ede48111209a050},
+	{0x83ea2b892091e44d,0x934aed0aab460432}, {0xa4e4b66b68b65d60,0xf81da84d5617853f},
+	{0xce1de40642e3f4b9,0x36251260ab9d668e}, {0x80d2ae83e9ce78f3,0xc1d72b7c6b426019},
+	{0xa1075a24e4421730,0xb24cf65b8612f81f}, {0xc94930ae1d529cfc,0xdee033f26797b627},
+	{0xfb9b7cd9a4a7443c,0x169840ef017da3b1}, {0x9d412e0806e88aa5,0x8e1f289560ee864e},
+	{0xc491798a08a2ad4e,0xf1a6f2bab92a27e2}, {0xf5b5d7ec8acb58a2,0xae10af696774b1db},
+	{0x9991a6f3d6bf1765,0xacca6da1e0a8ef29}, {0xbff610b0cc6edd3f,0x17fd090a58d32af3},
+	{0xeff394dcff8a948e,0xddfc4b4cef07f5b0}, {0x95f83d0a1fb69cd9,0x4abdaf101564f98e},
+	{0xbb764c4ca7a4440f,0x9d6d1ad41abe37f1}, {0xea53df5fd18d5513,0x84c86189216dc5ed},
+	{0x92746b9be2f8552c,0x32fd3cf5b4e49bb4}, {0xb7118682dbb66a77,0x3fbc8c33221dc2a1},
+	{0xe4d5e82392a40515,0x0fabaf3feaa5334a}, {0x8f05b1163ba6832d,0x29cb4d87f2a7400e},
+	{0xb2c71d5bca9023f8,0x743e20e9ef511012}, {0xdf78e4b2bd342cf6,0x914da9246b255416},
+	{0x8bab8eefb6409c1a,0x1ad089b6c2f7548e}, {0xae9672aba3d0c320,0xa184ac2473b529b1},
+	{0xda3c0f568cc4f3e8,0xc9e5d72d90a2741e}, {0x8865899617fb1871,0x7e2fa67c7a658892},
+	{0xaa7eebfb9df9de8d,0xddbb901b98feeab7}, {0xd51ea6fa85785631,0x552a74227f3ea565},
+	{0x8533285c936b35de,0xd53a88958f87275f}, {0xa67ff273b8460356,0x8a892abaf368f137},
+	{0xd01fef10a657842c,0x2d2b7569b0432d85}, {0x8213f56a67f6b29b,0x9c3b29620e29fc73},
+	{0xa298f2c501f45f42,0x8349f3ba91b47b8f}, {0xcb3f2f7642717713,0x241c70a936219a73},
+	{0xfe0efb53d30dd4d7,0xed238cd383aa0110}, {0x9ec95d1463e8a506,0xf4363804324a40aa},
+	{0xc67bb4597ce2ce48,0xb143c6053edcd0d5}, {0xf81aa16fdc1b81da,0xdd94b7868e94050a},
+	{0x9b10a4e5e9913128,0xca7cf2b4191c8326}, {0xc1d4ce1f63f57d72,0xfd1c2f611f63a3f0},
+	{0xf24a01a73cf2dccf,0xbc633b39673c8cec}, {0x976e41088617ca01,0xd5be0503e085d813},
+	{0xbd49d14aa79dbc82,0x4b2d8644d8a74e18}, {0xec9c459d51852ba2,0xddf8e7d60ed1219e},
+	{0x93e1ab8252f33b45,0xcabb90e5c942b503}, {0xb8da1662e7b00a17,0x3d6a751f3b936243},
+	{0xe7109bfba19c0c9d,0x0cc512670a783ad4}, {0x906a617d450187e2,0x27fb2b80668b24c5},
+	{0xb484f9dc9641e9da,0xb1f9f660802dedf6}, {0xe1a63853bbd26451,0x5e7873f8a0396973},
+	{0x8d07e33455637eb2,0xdb0b487b6423e1e8}, {0xb049dc016abc5e5f,0x91ce1a9a3d2cda62},
+	{0xdc5c5301c56b75f7,0x7641a140cc7810fb}, {0x89b9b3e11b6329ba,0xa9e904c87fcb0a9d},
+	{0xac2820d9623bf429,0x546345fa9fbdcd44}, {0xd732290fbacaf133,0xa97c177947ad4095},
+	{0x867f59a9d4bed6c0,0x49ed8eabcccc485d}, {0xa81f301449ee8c70,0x5c68f256bfff5a74},
+	{0xd226fc195c6a2f8c,0x73832eec6fff3111}, {0x83585d8fd9c25db7,0xc831fd53c5ff7eab},
+	{0xa42e74f3d032f525,0xba3e7ca8b77f5e55}, {0xcd3a1230c43fb26f,0x28ce1bd2e55f35eb},
+	{0x80444b5e7aa7cf85,0x7980d163cf5b81b3}, {0xa0555e361951c366,0xd7e105bcc332621f},
+	{0xc86ab5c39fa63440,0x8dd9472bf3fefaa7}, {0xfa856334878fc150,0xb14f98f6f0feb951},
+	{0x9c935e00d4b9d8d2,0x6ed1bf9a569f33d3}, {0xc3b8358109e84f07,0x0a862f80ec4700c8},
+	{0xf4a642e14c6262c8,0xcd27bb612758c0fa}, {0x98e7e9cccfbd7dbd,0x8038d51cb897789c},
+	{0xbf21e44003acdd2c,0xe0470a63e6bd56c3}, {0xeeea5d5004981478,0x1858ccfce06cac74},
+	{0x95527a5202df0ccb,0x0f37801e0c43ebc8}, {0xbaa718e68396cffd,0xd30560258f54e6ba},
+	{0xe950df20247c83fd,0x47c6b82ef32a2069}, {0x91d28b7416cdd27e,0x4cdc331d57fa5441},
+	{0xb6472e511c81471d,0xe0133fe4adf8e952}, {0xe3d8f9e563a198e5,0x58180fddd97723a6},
+	{0x8e679c2f5e44ff8f,0x570f09eaa7ea7648}
+};
+
+static inline uint64_t json_mul128(uint64_t a, uint64_t b, uint64_t& hi) {  // the low half of @a * @b
+#ifdef __SIZEOF_INT128__
+	__extension__ typedef unsigned __int128 json_uint128;  // not ISO C++, which -pedantic would warn of
+	json_uint128 r = (json_uint128)a * b;
+	hi = (uint64_t)(r >> 64);
+	return (uint64_t)r;
+#else
+	uint64_t a0 = (uint32_t)a, a1 = a >> 32, b0 = (uint32_t)b, b1 = b >> 32;
+	uint64_t p00 = a0*b0, p01 = a0*b1, p10 = a1*b0, p11 = a1*b1;
+	uint64_t mid = (p00 >> 32) + (uint32_t)p01 + (uint32_t)p10;
+	hi = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+	return (mid << 32) | (uint32_t)p00;
+#endif
+}
 
-	accept_number: case 5: case 6: case 8: case 11: {
-		std::string s = in.substr(start-in.begin(),pos-start);
-		const char *startp=s.c_str();
-		char *endp=0;
-		double v = strtod(startp,&endp);
-		if (startp==endp)
-			throw runtime_error(json_fmt("%d: JSON number does not parse",start-in.begin()));
-		out = v;
-		} break;
+static inline unsigned json_clz(uint64_t x) {  // @x is not 0
+#ifdef __GNUC__
+	return __builtin_clzll(x);
+#else
+	unsigned n = 0;
+	for (; !(x >> 63) ; x <<= 1) ++n;
+	return n;
+#endif
+}
 
-	accept_string: case 13:
-		out = *str;
-		delete str; str = 0;
-		break;
+static bool json_lemire(uint64_t w, int q, double& d) {
+	// sets @d to @w * 10^@q, rounded to nearest even, for @w not 0 and @q in
+	// -342...308; returns false when the product is too close to call
+	unsigned lz = json_clz(w);
+	w <<= lz;
+	const uint64_t *pow5 = json_pow5[q+342];
+	uint64_t hi, lo = json_mul128(w, pow5[0], hi);
+	if ((hi & 0x1FF) == 0x1FF) {  // the next 64 bits of 5^q could carry into the ones kept
+		uint64_t hi2;
+		json_mul128(w, pow5[1], hi2);
+		lo += hi2;
+		if (hi2 > lo)
+			++hi;
+		if (lo == ~(uint64_t)0)
+			return false;
+	}
 
-	accept_array: case 16:
-		out.set(array);
-		break;
-	
-	accept_object: case 20:
-		out.set(object);
-		break;
+	int upperbit = (int)(hi >> 63);
+	int shift = upperbit + 64 - 52 - 3;
+	uint64_t mantissa = hi >> shift;
+	int power2 = (int)((((152170 + 65536) * (int64_t)q) >> 16) + 63) + upperbit - (int)lz + 1023;
 
-	default:
-		throw runtime_error(json_fmt("%d: JSON invalid end of input",pos-in.begin()));
+	if (power2 <= 0) {  // subnormal
+		if (-power2 + 1 >= 64) {
+			d = 0.0;
+			return true;
+		}
+		mantissa >>= -power2 + 1;
+		mantissa += mantissa & 1;
+		mantissa >>= 1;
+		power2 = mantissa < ((uint64_t)1 << 52) ? 0 : 1;
+	} else {
+		if (lo <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 && (mantissa << shift) == hi)
+			mantissa &= ~(uint64_t)1;  // exactly halfway: round down to even
+		mantissa += mantissa & 1;
+		mantissa >>= 1;
+		if (mantissa >= ((uint64_t)2 << 52)) {
+			mantissa = (uint64_t)1 << 52;
+			++power2;
+		}
+		mantissa &= ~((uint64_t)1 << 52);
+		if (power2 >= 0x7FF) {
+			power2 = 0x7FF;
+			mantissa = 0;
+		}
 	}
-
-	return pos;
+	uint64_t bits = mantissa | (uint64_t)power2 << 52;
+	memcpy(&d, &bits, sizeof(d));
+	return true;
 }
 
+static double json_strtod(const char *p, const char *end) {
+	// strtod() of @p...@end, with '.' taken as the decimal point whatever
+	// the locale
+	std::string number(p, end);
+	const char *point = localeconv()->decimal_point;
+	if (point[0]!='.' || point[1]) {
+		size_t i = number.find('.');
+		if (i!=std::string::npos)
+			number.replace(i, 1, point);
+	}
+	return strtod(number.c_str(), 0);
+}
+
+JSONNumber json_parse_number(const char *p, const char *end) {
+	// the number at @p...@end, which json_scan_number() accepted; integers
+	// that fit are kept as int64_t
+	const char *start = p;
+	bool negative = *p=='-';
+	if (negative)
+		++p;
+
+	uint64_t w = 0;
+	int digits = 0;  // significant digits in @w
+	bool truncated = false;  // nonzero digits did not fit in @w
+	int64_t q = 0;
+	for (; p!=end && *p>='0' && *p<='9' ; ++p) {
+		if (digits < 19) {
+			w = w*10 + (*p-'0');
+			digits += w!=0;
+		} else {
+			++q;
+			truncated |= *p!='0';
+		}
+	}
+	if (p==end && !q && (negative ? w-1 : w) < (uint64_t)1 << 63) {  // "-0" stays a double
+		return JSONNumber(negative ? (int64_t)(0-w) : (int64_t)w);
+	}
+	if (p!=end && *p=='.') {
+		for (++p ; p!=end && *p>='0' && *p<='9' ; ++p) {
+			if (digits < 19) {
+				w = w*10 + (*p-'0');
+				digits += w!=0;
+				--q;
+			} else {
+				truncated |= *p!='0';
+			}
+		}
+	}
+	if (p!=end) {  // 'E' or 'e'
+		bool minus = *++p=='-';
+		if (*p=='+' || *p=='-')
+			++p;
+		int64_t e = 0;
+		for (; p!=end ; ++p)
+			if (e < 1000000)
+				e = e*10 + (*p-'0');
+		q += minus ? -e : e;
+	}
+
+	double d;
+	if (truncated) {
+		return JSONNumber(json_strtod(start, end));
+	} else if (!w || q < -342) {
+		d = 0.0;
+	} else if (q > 308) {
+		d = HUGE_VAL;
+	} else if (q==0) {
+		d = (double)w;
+	} else if (w <= (uint64_t)1 << 53 && q >= -22 && q <= 22) {
+		d = q < 0 ? (double)w / json_pow10[-q] : (double)w * json_pow10[q];
+	} else if (!json_lemire(w, (int)q, d)) {
+		return JSONNumber(json_strtod(start, end));
+	}
+	return JSONNumber(negative ? -d : d);
+}
 
-////////////////////////////////////////////////////////////////////////////////
-
 
 //
-// decoding from istream
+// stage 2 of decoding from a string: json_parse() reads the tokens at the
+// positions of the structural index in one loop, and json_decode() builds
+// the tree from what it reads, with an explicit stack of open arrays and objects
 //
-void json_decode(std::istream& in, JSON& out) {
-	int state = 0;
-	std::string *str;
-	JSONArray *array=0;
-	JSONObject *object=0;
-	JSON key;
-	string number;
-	for (char c = in.get() ; in.good() ; c = in.get()) {
-		switch (state) {
-		case 0:
-			switch (c) {
-
-			case ' ': case '\t': case '\r': case '\n':
-				break;
+const char *json_scan_number(const char *s, const char *p, const char *end, size_t base) {
+	// returns the end of the number at @p; @s is the start of the input, at @base in the positions of errors
+	const char *q = p;
+	if (*q=='-' && (++q==end || *q<'0' || *q>'9')) {
+		if (q==end) throw runtime_error(json_fmt("%d: JSON invalid end of input",(int)(base + (q-s))));
+		throw runtime_error(json_fmt("%d: JSON syntax error: expected digit after minus sign",(int)(base + (q-s))));
+	}
+	if (*q=='0') {
+		++q;
+	} else {
+		while (q!=end && *q>='0' && *q<='9') ++q;
+	}
+	if (q!=end && *q=='.') {
+		if (++q==end) throw runtime_error(json_fmt("%d: JSON invalid end of input",(int)(base + (q-s))));
+		if (*q<'0' || *q>'9') throw runtime_error(json_fmt("%d: JSON syntax error: expected digit after decimal point",(int)(base + (q-s))));
+		while (q!=end && *q>='0' && *q<='9') ++q;
+	}
+	if (q!=end && (*q=='E' || *q=='e')) {
+		if (++q==end) throw runtime_error(json_fmt("%d: JSON invalid end of input",(int)(base + (q-s))));
+		if (*q=='+' || *q=='-') {
+			if (++q==end) throw runtime_error(json_fmt("%d: JSON invalid end of input",(int)(base + (q-s))));
+			if (*q<'0' || *q>'9') throw runtime_error(json_fmt("%d: JSON syntax error: expected digit after 'E+' or 'E-'",(int)(base + (q-s))));
+		} else if (*q<'0' || *q>'9') {
+			throw runtime_error(json_fmt("%d: JSON syntax error: expected digit after 'E'",(int)(base + (q-s))));
+		}
+		while (q!=end && *q>='0' && *q<='9') ++q;
+	}
+	return q;
+}
 
-			case 'n':
-				c = in.get();
-				if (!in.good() || c!='u') throw runtime_error("JSON syntax error: expected \"null\"");
-				c = in.get();
-				if (!in.good() || c!='l') throw runtime_error("JSON syntax error: expected \"null\"");
-				c = in.get();
-				if (!in.good() || c!='l') throw runtime_error("JSON syntax error: expected \"null\"");
-
-				//state=1;
-				goto accept_null;
-
-			case 'f':
-				c = in.get();
-				if (!in.good() || c!='a') throw runtime_error("JSON syntax error: expected \"false\"");
-				c = in.get();
-				if (!in.good() || c!='l') throw runtime_error("JSON syntax error: expected \"false\"");
-				c = in.get();
-				if (!in.good() || c!='s') throw runtime_error("JSON syntax error: expected \"false\"");
-				c = in.get();
-				if (!in.good() || c!='e') throw runtime_error("JSON syntax error: expected \"false\"");
-
-				//state=2;
-				goto accept_false;
-			case 't':
-				c = in.get();
-				if (!in.good() || c!='r') throw runtime_error("JSON syntax error: expected \"true\"");
-				c = in.get();
-				if (!in.good() || c!='u') throw runtime_error("JSON syntax error: expected \"true\"");
-				c = in.get();
-				if (!in.good() || c!='e') throw runtime_error("JSON syntax error: expected \"true\"");
-
-				//state=3;
-				goto accept_true;
-
-			case '-':
-				number.push_back(c);
-				state=4;
-				break;
-			case '0':
-				number.push_back(c);
-				state=6;
-				break;
-			case '1': case '2': case '3':
-			case '4': case '5': case '6':
-			case '7': case '8': case '9':
-				number.push_back(c);
-				state=5;
-				break;
+static inline const char *json_string_run(const char *p, const char *end) {  // the first '"' or '\\' from @p, or @end
+#ifdef __SSE2__
+	const __m128i quote = _mm_set1_epi8('"'), backslash = _mm_set1_epi8('\\');
+	for (; end-p >= 32 ; p += 32) {
+		__m128i a = _mm_loadu_si128((const __m128i*)p);
+		__m128i b = _mm_loadu_si128((const __m128i*)(p+16));
+		uint64_t bits = (unsigned)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(a, quote), _mm_cmpeq_epi8(a, backslash)))
+			| (uint64_t)(unsigned)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(b, quote), _mm_cmpeq_epi8(b, backslash))) << 16;
+		if (bits)
+			return p + json_ctz(bits);
+	}
+	if (end-p >= 16) {
+		__m128i a = _mm_loadu_si128((const __m128i*)p);
+		unsigned bits = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(a, quote), _mm_cmpeq_epi8(a, backslash)));
+		if (bits)
+			return p + json_ctz(bits);
+		p += 16;
+	}
+#endif
+	while (p!=end && *p!='"' && *p!='\\')
+		++p;
+	return p;
+}
 
-			case '"':
-				str = new string();
-				state=12;
-				break;
-			case '[':
-				array = new JSONArray();
-				state=15;
-				break;
-			case '{':
-				object = new JSONObject();
-				state=19;
-				break;
-			default:
-				throw runtime_error("JSON syntax error: invalid token");
-			}
+static const char *json_unescape(const char *s, const char *p, const char *end, std::string& str, size_t base) {
+	// appends the characters after the opening quotes at @p to @str, and
+	// returns the position after the closing quotes
+	for (++p ;;) {
+		const char *q = json_string_run(p, end);
+		str.append(p, q);
+		if (q==end)
+			throw runtime_error(json_fmt("%d: JSON invalid end of input",(int)(base + (end-s))));
+		if (*q=='"')
+			return q+1;
+
+		if (++q==end)
+			throw runtime_error(json_fmt("%d: JSON invalid end of input",(int)(base + (end-s))));
+		switch (*q) {
+		case '"': case '\\': case '/':
+			str.push_back(*q);
 			break;
-
-		//
-		// NULL
-		//
-		//case 1:  // after null
-		//	in.unget();
-		//	goto accept_null;
-
-		//
-		// BOOLEAN
-		//
-		//case 2:  // after true
-		//	in.unget();
-		//	goto accept_true;
-		//case 3:  // after false
-		//	in.unget();
-		//	goto accept_false;
-
-		//
-		// NUMBER
-		//
-		case 4:  // after minus sign
-			switch (c) {
-			case '1': case '2': case '3':
-			case '4': case '5': case '6':
-			case '7': case '8': case '9':
-				number.push_back(c);
-				state=5;
-				break;
-			case '0':
-				number.push_back(c);
-				state=6;
-				break;
-			default:
-				throw runtime_error("JSON syntax error: expected digit after minus sign");
-			}
+		case 'b':
+			str.push_back('\b');
 			break;
-		case 5:  // after first digit
-			switch (c) {
-			case '0': case '1': case '2': case '3': case '4':
-			case '5': case '6': case '7': case '8': case '9':
-				number.push_back(c);
-				//state=5;
-				break;
-			case '.':
-				number.push_back(c);
-				state=7;
-				break;
-			case 'E': case 'e':
-				number.push_back(c);
-				state=9;
-				break;
-			default:
-				in.unget();
-				goto accept_number;
-			}
+		case 'f':
+			str.push_back('\f');
 			break;
-		case 6:  // after zero first digit
-			switch (c) {
-			case '.':
-				number.push_back(c);
-				state=7;
-				break;
-			case 'E': case 'e':
-				number.push_back(c);
-				state=9;
-				break;
-			default:
-				in.unget();
-				goto accept_number;
-			}
+		case 'n':
+			str.push_back('\n');
 			break;
-		case 7:  // after decimal point
-			switch (c) {
-			case '0': case '1': case '2': case '3': case '4':
-			case '5': case '6': case '7': case '8': case '9':
-				number.push_back(c);
-				state=8;
-				break;
+		case 'r':
+			str.push_back('\r');
+			break;
+		case 't':
+			str.push_back('\t');
+			break;
+		case 'u': {
+			if (end-q < 4)
+				throw runtime_error(json_fmt("%d: JSON syntax error: expected at least 4 characters after '\\u'",(int)(base + (q-s))));
+
+			unsigned long hex=0;
+			size_t i;
+			for (i = 0 ; i < 4 && q+1!=end ; ++i) {
+				int d;
+				switch (q[1]) {
+				case '0': case '1': case '2': case '3': case '4':
+				case '5': case '6': case '7': case '8': case '9':
+					d = q[1]-'0'; break;
+				case 'a': case 'b': case 'c': case 'd': case 'e': case 'f':
+					d = q[1]-'a'+10; break;
+				case 'A': case 'B': case 'C': case 'D': case 'E': case 'F':
+					d = q[1]-'A'+10; break;
+				default:
+					goto endhex;
+				}
+				hex = hex*16 + d;
+				++q;
+			}
+			endhex:
+
+			if (i < 4)
+				throw runtime_error(json_fmt("%d: JSON syntax error: expected 4 hex digits after '\\u'",(int)(base + (q-s))));
+
+			wchar_t wc[2];
+			wc[0] = hex;
+			wc[1] = 0;
+			char mb[17];
+			mb[16] = 0;
+			i = wcstombs(mb,wc,16);
+			if (i!=(size_t)-1 && i<=16)
+				str.append(mb, i);
+			} break;
+		default:
+			throw runtime_error(json_fmt("%d: JSON syntax error: invalid backslash escape",(int)(base + (q-s))));
+		}
+		p = q+1;
+	}
+}
+
+const char *json_scan_string(const char *s, const char *p, const char *end, std::string& buf, const char *&str, size_t& n, size_t base) {
+	// @p is at the opening quotes; @str is set to the characters in the
+	// input, or, when they have escapes, in @buf; returns the position after
+	// the closing quotes; errors are at @base plus their distance from @s
+	const char *q = json_string_run(p+1, end);
+	if (q!=end && *q=='"') {  // no escapes, take it as it is
+		str = p+1;
+		n = q-p-1;
+		return q+1;
+	}
+	buf.clear();
+	q = json_unescape(s, p, end, buf, base);
+	str = buf.data();
+	n = buf.size();
+	return q;
+}
+
+static inline JSON *json_push(std::vector<JSON>& values) {  // a new null value on top of the stack
+	values.push_back(JSON());
+	return &values.back();
+}
+
+struct json_frame {
+	JSONObject *object;  // 0 for an array
+	size_t base;  // array: index of its first element in the value stack
+	JSON *slot;  // array: where it goes when it is complete, or 0 for the value stack
+	bool owned;  // object: see json_member()
+};
+
+class json_builder {  // the json_parse() handler of json_decode()
+	// elements of open arrays wait in a value stack, so that each array is
+	// allocated with its exact size when it closes; objects are filled in place
+	const char *s, *end;  // the input, for borrowing strings
+	json_context cx, copy;  // @copy does not borrow
+	std::vector<json_frame> stack;
+	std::vector<JSON> values;
+	std::string buf;  // the current key, one buffer reused for every key
+	JSON *member;  // slot of the current object member
+
+	inline JSON *slot() { return stack.empty() ? &root : stack.back().object ? member : json_push(values); }
+public:
+	JSON root;
+
+	json_builder(const char *s, size_t n, const json_context& cx) : s(s), end(s+n), cx(cx), copy(cx.arena), member(0) { }
+
+	inline void null() { slot()->set(0); }
+	inline void boolean(bool v) { *slot() = v; }
+	inline void number(const JSONNumber& v) {
+		JSON *x = slot();
+		if (v.integer())
+			*x = v.int64();
+		else
+			*x = v.value();
+	}
+	inline void string(const char *p, size_t n) {
+		std::less<const char*> before;
+		json_set_string(*slot(), p, n, !before(p,s) && before(p,end) ? cx : copy);
+	}
+	inline void key(const char *p, size_t n) {
+		buf.assign(p, n);
+		member = &json_member(*stack.back().object, buf, cx.arena, stack.back().owned);
+	}
+	inline void start_array() {
+		json_frame f = { 0, values.size(), stack.empty() ? &root : stack.back().object ? member : 0, false };
+		stack.push_back(f);
+	}
+	inline void end_array() {
+		json_frame f = stack.back();
+		stack.pop_back();
+		JSON *slot = f.slot ? f.slot : json_push(values);
+		JSONArray *array = json_new_array(cx.arena);
+		slot->set(array);
+		size_t count = values.size() - f.base - !f.slot;
+		array->reserve(count);
+		for (size_t k = 0 ; k < count ; ++k)
+			array->push_back(std::move(values[f.base+k]));
+		if (!f.slot)
+			values[f.base] = std::move(values.back());
+		values.resize(f.base + !f.slot);
+	}
+	inline void start_object() {
+		JSONObject *object = json_new_object(cx.arena);
+		slot()->set(object);
+		json_frame f = { object, 0, 0, false };
+		stack.push_back(f);
+	}
+	inline void end_object() { stack.pop_back(); }
+};
+
+static void json_decode(const char *s, size_t n, JSON& out, const json_context& cx) {
+	json_builder b(s, n, cx);
+	json_parse(s, n, b);
+	out = std::move(b.root);
+}
+
+
+//
+// decoding from string
+//
+void json_decode(const char *s, size_t n, JSON& out) {
+	json_decode(s,n,out,json_context());
+}
+void json_decode(const char *s, size_t n, JSONDocument& out) {
+	out.clear();
+	try {
+		json_decode(s,n,out.r,json_context(&out.a));
+	} catch (...) {
+		out.clear();
+		throw;
+	}
+}
+void json_decode_borrowed(const char *s, size_t n, JSONDocument& out) {
+	out.clear();
+	try {
+		json_decode(s,n,out.r,json_context(&out.a,true));
+	} catch (...) {
+		out.clear();
+		throw;
+	}
+}
+size_t json_decode_prefix(const char *s, size_t n, JSON& out) {
+	json_index i(s, n);
+	json_builder b(s, n, json_context());
+	const char *end = json_parse_value(s, n, i, b);
+	out = std::move(b.root);
+	return end-s;
+}
+
+void json_decode(const std::string& in, JSON& out) {
+	json_decode(in.data(),in.size(),out);
+}
+void json_decode(const std::string& in, JSONDocument& out) {
+	json_decode(in.data(),in.size(),out);
+}
+void json_decode_borrowed(const std::string& in, JSONDocument& out) {
+	json_decode_borrowed(in.data(),in.size(),out);
+}
+
+
+//
+// pull parsing
+//
+JSONReader::JSONReader(const char *s, size_t n)
+	: s(s), n(n), i(s, n), state(VALUE), t(END), p(0), b(false), str(0), len(0) {
+}
+JSONReader::JSONReader(const std::string& in)
+	: s(in.data()), n(in.size()), i(s, n), state(VALUE), t(END), p(0), b(false), str(0), len(0) {
+}
+
+JSONReader::Token JSONReader::next() {
+	const char *end = s+n;
+	switch (state) {
+	case DONE:
+		return t = END;
+	case CLOSE:  // of an empty array or object
+		p = s + i.next();
+		stack.pop_back();
+		state = AFTER_VALUE;
+		return t = *p==']' ? ARRAY_END : OBJECT_END;
+	case KEY_NEXT:
+		break;
+	case AFTER_VALUE:
+		if (stack.empty()) {
+			if (!i.done())
+				throw runtime_error(json_fmt("%d: JSON syntax error",(int)i.peek()));
+			state = DONE;
+			return t = END;
+		}
+		if (i.done())
+			throw runtime_error(json_fmt("%d: JSON invalid end of input",(int)n));
+		p = s + i.next();
+		if (!stack.back()) {
+			switch (*p) {
+			case ',':
+				state = VALUE;
+				return next();
+			case ']':
+				stack.pop_back();
+				return t = ARRAY_END;
 			default:
-				throw runtime_error("JSON syntax error: expected digit after decimal point");
+				throw runtime_error(json_fmt("%d: JSON syntax error: expected ',' or ']' after array element",(int)(p-s)));
 			}
+		}
+		switch (*p) {
+		case ',':
+			if (i.done())
+				throw runtime_error(json_fmt("%d: JSON invalid end of input",(int)n));
+			if (s[i.peek()]!='"')
+				throw runtime_error(json_fmt("%d: JSON syntax error: expected '\"' after comma in object",(int)i.peek()));
 			break;
-		case 8:  // after first decimal digit
-			switch (c) {
-			case '0': case '1': case '2': case '3': case '4':
-			case '5': case '6': case '7': case '8': case '9':
-				number.push_back(c);
-				//state=8;
-				break;
-			case 'E': case 'e':
-				number.push_back(c);
-				state=9;
-				break;
-			default:
-				in.unget();
-				goto accept_number;
+		case '}':
+			stack.pop_back();
+			return t = OBJECT_END;
+		default:
+			throw runtime_error(json_fmt("%d: JSON syntax error: expected ',' or '}' after object key-value pair",(int)(p-s)));
+		}
+		break;
+	case VALUE:
+		if (i.done())
+			throw runtime_error(json_fmt("%d: JSON invalid end of input",(int)n));
+		p = s + i.next();
+		state = AFTER_VALUE;
+		switch (*p) {
+		case '[':
+			if (json_max_depth && stack.size() >= json_max_depth)
+				throw runtime_error(json_fmt("%d: JSON nesting too deep",(int)(p-s)));
+			stack.push_back(false);
+			state = !i.done() && s[i.peek()]==']' ? CLOSE : VALUE;
+			return t = ARRAY_START;
+		case '{':
+			if (json_max_depth && stack.size() >= json_max_depth)
+				throw runtime_error(json_fmt("%d: JSON nesting too deep",(int)(p-s)));
+			stack.push_back(true);
+			if (!i.done() && s[i.peek()]=='}') {
+				state = CLOSE;
+				return t = OBJECT_START;
 			}
+			if (i.done())
+				throw runtime_error(json_fmt("%d: JSON invalid end of input",(int)n));
+			if (s[i.peek()]!='"')
+				throw runtime_error(json_fmt("%d: JSON syntax error: expected '}' or '\"' after object start",(int)i.peek()));
+			state = KEY_NEXT;
+			return t = OBJECT_START;
+		case 'n':
+			if (end-p<4 || strncmp(p,"null",4)!=0 || !json_delimiter(p+4,end))
+				throw runtime_error(json_fmt("%d: JSON syntax error: expected \"null\"",(int)(p-s)));
+			return t = NULL_VALUE;
+		case 'f':
+			if (end-p<5 || strncmp(p,"false",5)!=0 || !json_delimiter(p+5,end))
+				throw runtime_error(json_fmt("%d: JSON syntax error: expected \"false\"",(int)(p-s)));
+			b = false;
+			return t = BOOLEAN;
+		case 't':
+			if (end-p<4 || strncmp(p,"true",4)!=0 || !json_delimiter(p+4,end))
+				throw runtime_error(json_fmt("%d: JSON syntax error: expected \"true\"",(int)(p-s)));
+			b = true;
+			return t = BOOLEAN;
+		case '-':
+		case '0': case '1': case '2': case '3': case '4':
+		case '5': case '6': case '7': case '8': case '9': {
+			const char *q = json_scan_number(s, p, end);
+			if (!json_delimiter(q,end))
+				throw runtime_error(json_fmt("%d: JSON syntax error: unexpected character after number",(int)(q-s)));
+			num = json_parse_number(p, q);
+			return t = NUMBER;
+			}
+		case '"':
+			json_scan_string(s, p, end, buf, str, len);
+			return t = STRING;
+		default:
+			throw runtime_error(json_fmt("%d: JSON syntax error: invalid token",(int)(p-s)));
+		}
+	}
+
+	// the next position is the opening quotes of a key
+	p = s + i.next();
+	const char *q = json_scan_string(s, p, end, buf, str, len);
+	if (i.done())
+		throw runtime_error(json_fmt("%d: JSON invalid end of input",(int)n));
+	if (s[i.peek()]!=':' || (size_t)(q-s) > i.peek())
+		throw runtime_error(json_fmt("%d: JSON syntax error: expected ':' after object key",(int)(q-s)));
+	i.next();
+	state = VALUE;
+	return t = KEY;
+}
+
+void JSONReader::skip() {
+	// only the brackets of what is skipped are looked at, not its tokens
+	if (t==KEY)
+		next();
+	if (t!=ARRAY_START && t!=OBJECT_START)
+		return;
+	if (state==CLOSE) {
+		next();
+		return;
+	}
+	for (size_t depth = 1 ;;) {
+		if (i.done())
+			throw runtime_error(json_fmt("%d: JSON invalid end of input",(int)n));
+		p = s + i.next();
+		switch (*p) {
+		case '[': case '{':
+			++depth;
 			break;
-		case 9:  // after E
-			switch (c) {
-			case '+': case '-':
-				number.push_back(c);
-				state=10;
-				break;
-			case '0': case '1': case '2': case '3': case '4':
-			case '5': case '6': case '7': case '8': case '9':
-				number.push_back(c);
-				state=11;
-				break;
-			default:
-				throw runtime_error("JSON syntax error: expected digit after 'E'");
+		case ']': case '}':
+			if (!--depth) {
+				if ((*p=='}')!=(bool)stack.back())
+					throw runtime_error(json_fmt("%d: JSON syntax error: mismatched brackets",(int)(p-s)));
+				stack.pop_back();
+				state = AFTER_VALUE;
+				t = *p==']' ? ARRAY_END : OBJECT_END;
+				return;
 			}
 			break;
-		case 10:  // after E+ or E-
-			switch (c) {
-			case '0': case '1': case '2': case '3': case '4':
-			case '5': case '6': case '7': case '8': case '9':
-				number.push_back(c);
-				state=11;
-				break;
-			default:
-				throw runtime_error("JSON syntax error: expected digit after 'E+' or 'E-'");
+		}
+	}
+}
+
+void JSONReader::value(JSON& out) {
+	if (t==KEY)
+		next();
+	switch (t) {
+	case NULL_VALUE: out.set(0); break;
+	case BOOLEAN: out = b; break;
+	case NUMBER: out = num.integer() ? JSON(num.int64()) : JSON(num.value()); break;
+	case STRING: out = std::string(str, len); break;
+	case ARRAY_START: case OBJECT_START: {
+		const char *start = p;
+		skip();
+		json_decode(start, p+1-start, out, json_context());
+		} break;
+	default:
+		throw json_type_error("not at a JSON value");
+	}
+}
+
+
+//
+// decoding from file
+//
+class json_mapping {  // a file mapped read-only, or read into memory where it cannot be mapped
+	void *addr;
+	size_t size;
+	std::string copy;
+
+	json_mapping(const json_mapping&);
+	json_mapping& operator=(const json_mapping&);
+public:
+	json_mapping(const char *path);
+	inline ~json_mapping() { if (addr) munmap(addr, size); }
+
+	inline const char *data() const { return addr ? (const char*)addr : copy.data(); }
+	inline size_t length() const { return addr ? size : copy.size(); }
+};
+
+json_mapping::json_mapping(const char *path) : addr(0), size(0) {
+	int fd = open(path, O_RDONLY);
+	if (fd==-1)
+		throw runtime_error(json_fmt("%s: %s", path, strerror(errno)));
+	struct stat st;
+	if (fstat(fd, &st)==0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+		size = st.st_size;
+		addr = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (addr==MAP_FAILED)
+			addr = 0;
+		else
+			madvise(addr, size, MADV_SEQUENTIAL);
+	}
+	if (!addr) {  // a pipe or the like
+		char buf[65536];
+		for (;;) {
+			ssize_t r = read(fd, buf, sizeof(buf));
+			if (r > 0) {
+				copy.append(buf, r);
+			} else if (r==0) {
+				break;
+			} else if (errno!=EINTR) {
+				int e = errno;
+				close(fd);
+				throw runtime_error(json_fmt("%s: %s", path, strerror(e)));
 			}
+		}
+	}
+	close(fd);
+}
+
+void json_decode_file(const char *path, JSON& out) {
+	json_mapping file(path);
+	json_decode(file.data(),file.length(),out,json_context());
+}
+void json_decode_file(const char *path, JSONDocument& out) {
+	out.clear();
+	try {
+		json_mapping *file = new (out.a.allocate(sizeof(json_mapping), alignof(json_mapping))) json_mapping(path);
+		out.a.own(file);
+		json_decode(file->data(),file->length(),out.r,json_context(&out.a,true));
+	} catch (...) {
+		out.clear();
+		throw;
+	}
+}
+
+
+//
+// lazy decoding: the document keeps the position of every value, key and
+// closing bracket, and for each, the token after the value that starts
+// there; the elements and members of a value are found by hopping over those
+//
+struct json_checker {  // the json_parse() handler that only lets it check the syntax
+	inline void null() { }
+	inline void boolean(bool) { }
+	inline void number(const JSONNumber&) { }
+	inline void string(const char *, size_t) { }
+	inline void key(const char *, size_t) { }
+	inline void start_array() { }
+	inline void end_array() { }
+	inline void start_object() { }
+	inline void end_object() { }
+};
+
+class json_lazy_index {  // a json_index that keeps the tokens it gives out in a JSONLazyDocument
+	json_index i;
+	const char *s;
+	std::vector<JSONLazyDocument::token>& t;
+	std::vector<size_t> open;  // brackets
+public:
+	json_lazy_index(const char *s, size_t n, std::vector<JSONLazyDocument::token>& t) : i(s, n), s(s), t(t) { }
+
+	inline bool done() { return i.done(); }
+	inline size_t peek() const { return i.peek(); }
+	inline size_t next() {
+		size_t p = i.next(), k = t.size();
+		switch (s[p]) {
+		case ',': case ':':
+			return p;
+		case '[': case '{':
+			open.push_back(k);
 			break;
-		case 11:  // after first exponent digit
-			switch (c) {
-			case '0': case '1': case '2': case '3': case '4':
-			case '5': case '6': case '7': case '8': case '9':
-				number.push_back(c);
-				//state=11;
-				break;
-			default:
-				in.unget();
-				goto accept_number;
+		case ']': case '}':
+			if (!open.empty()) {  // or the parser is about to throw
+				t[open.back()].after = k+1;
+				open.pop_back();
 			}
 			break;
+		}
+		JSONLazyDocument::token x = { (uint32_t)p, (uint32_t)(k+1) };
+		t.push_back(x);
+		return p;
+	}
+};
+
+JSONLazyDocument::JSONLazyDocument(const char *s, size_t n) : s(s), n(n) {
+	if (n >= (uint32_t)-1)
+		throw std::runtime_error("JSON input too large for JSONLazyDocument");
+	json_checker checker;
+	t.reserve(n/8);  // as many tokens as typical input has, to save reallocating
+	json_lazy_index i(s, n, t);
+	json_parse_value(s, n, i, checker);
+	if (!i.done())
+		throw std::runtime_error(json_fmt("%d: JSON syntax error",(int)i.peek()));
+}
+JSONLazyDocument::JSONLazyDocument(const std::string& in) : JSONLazyDocument(in.data(), in.size()) {
+}
 
-		//
-		// STRING
-		//
-		case 12:  // after opening quotes
-			switch (c) {
-			case '"':
-				//state=13;
-				goto accept_string;
-			case '\\':
-				state=14;
-				break;
-			default:
-				str->push_back(c);
+JSONType JSONLazy::type() const {
+	switch (c()) {
+	case 'n': return JSON_NULL;
+	case 't': case 'f': return JSON_BOOLEAN;
+	case '"': return JSON_STRING;
+	case '[': return JSON_ARRAY;
+	case '{': return JSON_OBJECT;
+	default: return JSON_NUMBER;
+	}
+}
+
+JSONLazy::iterator JSONLazy::begin() const {
+	if (c()!='[' && c()!='{')
+		throw json_type_error("not a JSON array or object");
+	return iterator(d, k+1, c()=='{');  // at the closing bracket when empty
+}
+JSONLazy::iterator JSONLazy::end() const {
+	if (c()!='[' && c()!='{')
+		throw json_type_error("not a JSON array or object");
+	return iterator(d, d->t[k].after-1, c()=='{');
+}
+size_t JSONLazy::size() const {
+	size_t count = 0;
+	for (iterator i = begin(), e = end() ; i!=e ; ++i)
+		++count;
+	return count;
+}
+
+size_t JSONLazy::element(size_t i) const {
+	if (c()!='[')
+		throw json_type_error("not a JSON array");
+	iterator j = begin(), e = end();
+	size_t at = 0;
+	if (ck && ci <= i) {
+		j.k = ck;
+		at = ci;
+	}
+	for (; j!=e ; ++j, ++at) {
+		if (at==i) {
+			ci = i;
+			ck = j.k;
+			return j.k;
+		}
+	}
+	return 0;
+}
+size_t JSONLazy::find(const char *key, size_t len) const {
+	// keys without escapes are compared as they are in the input
+	if (c()!='{')
+		throw json_type_error("not a JSON object");
+	size_t found = 0;
+	std::string buf;
+	for (iterator j = begin(), e = end() ; j!=e ; ++j) {
+		const char *p = d->s + d->t[j.k].pos + 1;
+		const char *q = d->s + d->t[j.k+1].pos;  // the ':' after the key
+		while (*--q!='"') ;  // back over spaces to its closing quote
+		if (!memchr(p, '\\', q-p)) {
+			if ((size_t)(q-p)==len && memcmp(p, key, len)==0)
+				found = j.k+1;
+		} else {
+			const char *str;
+			size_t n;
+			json_scan_string(d->s, p-1, d->s + d->n, buf, str, n);
+			if (n==len && memcmp(str, key, len)==0)
+				found = j.k+1;
+		}
+	}
+	return found;
+}
+
+JSONLazy JSONLazy::get(size_t i) const {
+	size_t e = element(i);
+	if (!e)
+		throw std::out_of_range(json_fmt("JSON array has no element %d", (int)i));
+	return at(e);
+}
+JSONLazy JSONLazy::get(const std::string& s) const {
+	size_t e = find(s.data(), s.size());
+	if (!e)
+		throw std::out_of_range(json_fmt("JSON object has no element %s", json_encode(JSONString(s)).c_str()));
+	return at(e);
+}
+
+bool JSONLazy::boolean() const {
+	if (type()!=JSON_BOOLEAN)
+		throw json_type_error("not a JSON boolean");
+	return c()=='t';
+}
+JSONNumber JSONLazy::number() const {
+	if (type()!=JSON_NUMBER)
+		throw json_type_error("not a JSON number");
+	const char *p = d->s + d->t[k].pos;
+	return json_parse_number(p, json_scan_number(d->s, p, d->s + d->n));
+}
+std::string JSONLazy::string() const {
+	if (type()!=JSON_STRING)
+		throw json_type_error("not a JSON string");
+	std::string buf;
+	const char *str;
+	size_t n;
+	json_scan_string(d->s, d->s + d->t[k].pos, d->s + d->n, buf, str, n);
+	return std::string(str, n);
+}
+JSON JSONLazy::decode() const {
+	JSON out;
+	switch (type()) {
+	case JSON_NULL: break;
+	case JSON_BOOLEAN: out = boolean(); break;
+	case JSON_NUMBER: {
+		JSONNumber v = number();
+		if (v.integer())
+			out = v.int64();
+		else
+			out = v.value();
+		} break;
+	case JSON_STRING: out = string(); break;
+	default: {
+		size_t start = d->t[k].pos;
+		json_decode(d->s + start, d->t[d->t[k].after-1].pos + 1 - start, out, json_context());
+		} break;
+	}
+	return out;
+}
+
+// scalars are decoded and converted as JSON values are
+JSONLazy::operator bool() const {
+	switch (type()) {
+	case JSON_ARRAY: throw json_type_error("JSON array cannot be converted to type bool");
+	case JSON_OBJECT: throw json_type_error("JSON object cannot be converted to type bool");
+	default: return (bool)decode();
+	}
+}
+JSONLazy::operator double() const {
+	switch (type()) {
+	case JSON_ARRAY: throw json_type_error("JSON array cannot be converted to type double");
+	case JSON_OBJECT: throw json_type_error("JSON object cannot be converted to type double");
+	default: return (double)decode();
+	}
+}
+JSONLazy::operator std::string() const {
+	switch (type()) {
+	case JSON_ARRAY: throw json_type_error("JSON array cannot be converted to type string");
+	case JSON_OBJECT: throw json_type_error("JSON object cannot be converted to type string");
+	default: return (std::string)decode();
+	}
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+
+
+//
+// decoding from istream: the end of the value is found in the stream buffer,
+// a buffer at a time, and the value is then decoded like a string
+//
+void json_decode(std::istream& in, JSON& out) {
+	json_decode(in,out,json_context());
+}
+void json_decode(std::istream& in, JSONDocument& out) {
+	out.clear();
+	try {
+		json_decode(in,out.r,json_context(&out.a));
+	} catch (...) {
+		out.clear();
+		throw;
+	}
+}
+class json_streambuf : public std::streambuf {  // reaches into the get area of any std::streambuf
+public:
+	static const char *begin(std::streambuf *sb) { return (sb->*&json_streambuf::gptr)(); }
+	static const char *end(std::streambuf *sb) { return (sb->*&json_streambuf::egptr)(); }
+	static void consume(std::streambuf *sb, size_t n) { (sb->*&json_streambuf::gbump)((int)n); }
+};
+
+inline void json_value_end::start(char c) {  // @c is the first character of the value
+	depth = 0;
+	in_string = escaped = false;
+	switch (c) {
+	case '-': case '0': case '1': case '2': case '3': case '4':
+	case '5': case '6': case '7': case '8': case '9': kind = NUMBER; state = 3; break;
+	case 'n': case 't': kind = LITERAL; state = 4; break;
+	case 'f': kind = LITERAL; state = 5; break;
+	default: kind = CONTAINER; break;  // and strings, and invalid tokens
+	}
+}
+
+inline const char *json_value_end::scan(const char *p, const char *e) {
+	// the end of the value, if it is in @p...@e, where the value goes on
+	// from the previous call; otherwise 0
+	switch (kind) {
+	case LITERAL:
+		if (e-p < state) {
+			state -= e-p;
+			return 0;
+		}
+		return p+state;
+
+	case NUMBER:
+		for (; p!=e ; ++p) {
+			char c = *p;
+			bool digit = c>='0' && c<='9';
+			switch (state) {
+			case 3: if (c=='-') state = 4; else if (c=='0') state = 6; else state = 5; break;
+			case 4: if (!digit) return p; state = c=='0' ? 6 : 5; break;
+			case 5: if (digit) break; // fall through
+			case 6: if (c=='.') state = 7; else if (c=='E' || c=='e') state = 9; else return p; break;
+			case 7: if (!digit) return p; state = 8; break;
+			case 8: if (c=='E' || c=='e') state = 9; else if (!digit) return p; break;
+			case 9: if (c=='+' || c=='-') state = 10; else if (digit) state = 11; else return p; break;
+			case 10: if (!digit) return p; state = 11; break;
+			case 11: if (!digit) return p; break;
 			}
-			break;
-		//case 13:  // after closing quotes
-		//	in.unget();
-		//	goto accept_string;
-		case 14:  // after backslash
-			switch (c) {
-			case '"': case '\\': case '/':
-				str->push_back(c);
-				break;
-			case 'b':
-				str->push_back('\b');
-				break;
-			case 'f':
-				str->push_back('\f');
-				break;
-			case 'n':
-				str->push_back('\n');
+		}
+		return 0;
+
+	case CONTAINER:
+		for (; p!=e ; ++p) {
+			if (in_string) {
+				if (escaped) {
+					escaped = false;
+					continue;
+				}
+				p = json_string_run(p, e);
+				if (p==e)
+					break;
+				if (*p=='\\') {
+					escaped = true;
+				} else {
+					in_string = false;
+					if (!depth)
+						return p+1;
+				}
+				continue;
+			}
+			switch (*p) {
+			case '"':
+				in_string = true;
 				break;
-			case 'r':
-				str->push_back('\r');
+			case '[': case '{':
+				++depth;
 				break;
-			case 't':
-				str->push_back('\t');
+			case ']': case '}':
+				if (depth <= 1)
+					return p+1;
+				--depth;
 				break;
-			case 'u': {
-				unsigned long hex=0;
-				size_t i;
-				for (i = 0 ; i < 4 ; ++i) {
-					c = in.get();
-					if (!in.good()) {
-						delete str; str = 0;
-						throw runtime_error("JSON syntax error: expected at least 4 characters after '\\u'");
-					}
+			default:
+				if (!depth)  // an invalid token
+					return p+1;
+			}
+		}
+		return 0;
+	}
+	return 0;
+}
 
-					hex *= 16;
-					switch (c) {
-					case '0': hex += 0; break;
-					case '1': hex += 1; break;
-					case '2': hex += 2; break;
-					case '3': hex += 3; break;
-					case '4': hex += 4; break;
-					case '5': hex += 5; break;
-					case '6': hex += 6; break;
-					case '7': hex += 7; break;
-					case '8': hex += 8; break;
-					case '9': hex += 9; break;
-					case 'a': case 'A': hex += 10; break;
-					case 'b': case 'B': hex += 11; break;
-					case 'c': case 'C': hex += 12; break;
-					case 'd': case 'D': hex += 13; break;
-					case 'e': case 'E': hex += 14; break;
-					case 'f': case 'F': hex += 15; break;
-					default:
-						in.unget();
-						goto endhex;
+const char *json_read_value(std::istream& in, std::string& buf, size_t& n) {
+	// takes the characters of the next value from @in, and returns where they
+	// are: still in the stream buffer when the value ends in there, and
+	// otherwise copied to @buf; only characters up to its end are taken from
+	// the stream, as in.get() would have
+	std::istream::sentry ok(in, true);
+	if (!ok)
+		throw runtime_error("JSON no token");
+	std::streambuf *sb = in.rdbuf();
+	json_value_end value;
+	bool started = false;
+	buf.clear();  // the value so far, once it goes on past a buffer
+	for (;;) {
+		const char *b = json_streambuf::begin(sb), *e = json_streambuf::end(sb);
+		if (b==e) {
+			int ch = sb->sgetc();
+			if (ch==char_traits<char>::eof()) {
+				in.setstate(ios::eofbit | ios::failbit);
+				if (!started)
+					throw runtime_error("JSON no token");
+				n = buf.size();
+				return buf.data();
+			}
+			b = json_streambuf::begin(sb), e = json_streambuf::end(sb);
+			if (b==e) {  // unbuffered: one character at a time, into @buf
+				char c = ch;
+				if (!started) {
+					if (c==' ' || c=='\t' || c=='\r' || c=='\n') {
+						sb->sbumpc();
+						continue;
 					}
+					value.start(c);
+					started = true;
 				}
-				endhex:
-
-				if (!i) {
-					delete str; str = 0;
-					throw runtime_error("JSON syntax error: no hex digits follow '\\u'");
+				const char *q = value.scan(&c, &c+1);
+				if (q!=&c) {
+					buf.push_back(c);
+					sb->sbumpc();
+				}
+				if (q) {
+					n = buf.size();
+					return buf.data();
 				}
+				continue;
+			}
+		}
+		if (e-b > (1<<30))
+			e = b + (1<<30);
+
+		const char *p = b;
+		if (!started) {
+			while (p!=e && (*p==' ' || *p=='\t' || *p=='\r' || *p=='\n'))
+				++p;
+			if (p!=e) {
+				value.start(*p);
+				started = true;
+			}
+		}
+		const char *q = started ? value.scan(p, e) : 0;
+		if (q && buf.empty()) {
+			json_streambuf::consume(sb, q-b);  // the characters stay where they are until the next read
+			n = q-p;
+			return p;
+		}
+		buf.append(p, q ? q : e);
+		json_streambuf::consume(sb, (q ? q : e) - b);
+		if (q) {
+			n = buf.size();
+			return buf.data();
+		}
+	}
+}
 
-				wchar_t wc[2];
-				wc[0] = hex;
-				wc[1] = 0;
+static void json_decode(std::istream& in, JSON& out, const json_context& cx) {
+	std::string buf;
+	size_t n;
+	const char *s = json_read_value(in, buf, n);
+	json_decode(s, n, out, cx);
+}
 
-				char mb[17];
-				mb[16] = 0;
 
-				i = wcstombs(mb,wc,16);
-				if (i==(size_t)-1 || i>16) {
-					//fprintf(stderr, "JSON could not convert wide char (ignoring): %lX\n", hex);
-				} else if (i) {
-					for (size_t j = 0 ; j < i ; ++j)
-						str->push_back(mb[j]);
-				}
-				} break;
-			default:
-				delete str; str = 0;
-				throw runtime_error("JSON syntax error: invalid backslash escape");
-			}
-			state=12;
+//
+// push parsing: a value that ends in the piece it starts in is decoded there
+// by json_decode(); one that goes on past its piece is parsed a token at a
+// time into a json_builder, which keeps its open arrays and objects from one
+// piece to the next, so only a token cut by the end of a piece is kept as
+// characters
+//
+static const char *json_string_end(const char *p, const char *e, bool& escaped) {
+	// the end of a string that goes on at @p, or 0 if it goes on past @e;
+	// @escaped: whether the character at @p is escaped, and then at @e
+	for (; p!=e ; ++p) {
+		if (escaped) {
+			escaped = false;
+			continue;
+		}
+		p = json_string_run(p, e);
+		if (p==e)
 			break;
+		if (*p=='"')
+			return p+1;
+		escaped = true;
+	}
+	return 0;
+}
 
-		//
-		// ARRAY
-		//
-		case 15:  // after array start
-			switch (c) {
-			case ' ': case '\t': case '\r': case '\n':
-				break;
-			case ']':
-				//state=16;
-				goto accept_array;
-			default:
-				in.unget();
-				array->push_back(JSON());
-				json_decode(in, array->back());
-				state=17;
+class json_push_parser {
+	enum { VALUE, FIRST_ELEMENT, FIRST_KEY, KEY, COLON, NEXT } state;  // what comes next
+	enum { NONE, STRING, NUMBER, LITERAL } cut;  // the token cut by the end of the last piece
+	json_builder b;
+	std::vector<bool> stack;  // open arrays and objects, true for an object
+	std::string token;  // the characters of the cut token so far
+	size_t token_at;  // where it starts in the value
+	bool escaped;  // STRING: the next character is escaped
+	json_value_end number;  // NUMBER: where it is in the number
+	size_t key_end;  // COLON: where the key ends in the value
+	const char *word;  // a literal, or "" for a number, that ended the last piece in an array or object, so a delimiter must follow
+	size_t word_at;  // and where the error would be
+	std::string buf;  // strings with escapes
+	size_t offset;  // of the current piece in the input
+	size_t start;  // of the current value in the input
+
+	inline bool idle() const { return state==VALUE && stack.empty() && !cut; }  // between values
+	inline size_t at(const char *s, const char *p) const { return offset + (p-s) - start; }
+	inline bool value(std::deque<JSON>& out);
+	bool take(const char *t, const char *q, const char *e, size_t pos, std::deque<JSON>& out);
+	const char *resume(const char *s, const char *e, std::deque<JSON>& out);
+	const char *parse(const char *s, const char *p, const char *e, std::deque<JSON>& out);
+public:
+	json_push_parser() : state(VALUE), cut(NONE), b(0, 0, json_context()), token_at(0), escaped(false), key_end(0), word(0), word_at(0), offset(0), start(0) { }
+
+	void feed(const char *s, size_t n, std::deque<JSON>& out);
+	void finish(std::deque<JSON>& out);
+};
+
+inline bool json_push_parser::value(std::deque<JSON>& out) {  // after a value; true if it is a whole one
+	if (!stack.empty()) {
+		state = NEXT;
+		return false;
+	}
+	out.push_back(std::move(b.root));
+	b.root = JSON();
+	state = VALUE;
+	return true;
+}
+
+bool json_push_parser::take(const char *t, const char *q, const char *e, size_t pos, std::deque<JSON>& out) {
+	// the token @t...@q, starting at @pos in the value, and followed by what
+	// has arrived of the input up to @e; returns whether it completes a
+	// value; values in a series may follow one another with no delimiter
+	bool top = stack.empty();
+	if (*t=='"') {
+		const char *str;
+		size_t len;
+		json_scan_string(t, t, e, buf, str, len, pos);  // errors at their position in the value, not in the token
+		if (state==FIRST_KEY || state==KEY) {
+			b.key(str, len);
+			key_end = pos + (q-t);
+			state = COLON;
+			return false;
+		}
+		b.string(str, len);
+	} else if (*t=='n' || *t=='t' || *t=='f') {
+		const char *literal = *t=='n' ? "null" : *t=='t' ? "true" : "false";
+		if ((size_t)(q-t)!=strlen(literal) || memcmp(t, literal, q-t)!=0 || (!top && q!=e && !json_delimiter(q, e)))
+			throw runtime_error(json_fmt("%d: JSON syntax error: expected \"%s\"",(int)pos,literal));
+		if (*t=='n')
+			b.null();
+		else
+			b.boolean(*t=='t');
+		if (!top && q==e) {
+			word = literal;
+			word_at = pos;
+		}
+	} else {
+		json_scan_number(t, t, e, pos);
+		if (!top && q!=e && !json_delimiter(q, e))
+			throw runtime_error(json_fmt("%d: JSON syntax error: unexpected character after number",(int)(pos + (q-t))));
+		b.number(json_parse_number(t, q));
+		if (!top && q==e) {
+			word = "";
+			word_at = pos + (q-t);
+		}
+	}
+	return value(out);
+}
+
+const char *json_push_parser::resume(const char *s, const char *e, std::deque<JSON>& out) {
+	// goes on with the cut token in the piece @s...@e, and returns the end of the token
+	const char *q;
+	if (cut==STRING) {
+		q = json_string_end(s, e, escaped);
+	} else if (cut==NUMBER) {
+		q = number.scan(s, e);
+	} else {
+		size_t left = (token[0]=='f' ? 5 : 4) - token.size();
+		q = (size_t)(e-s) < left ? 0 : s+left;
+	}
+	if (!q) {
+		token.append(s, e);
+		return e;
+	}
+	size_t n = token.size() + (q-s);
+	token.append(s, q!=e ? q+1 : q);  // and the character after it, for take()
+	cut = NONE;
+	take(token.data(), token.data()+n, token.data()+token.size(), token_at, out);
+	return q;
+}
+
+const char *json_push_parser::parse(const char *s, const char *p, const char *e, std::deque<JSON>& out) {
+	// goes on from @p, and returns the end of the piece @s...@e, or of the
+	// value if it ends before
+	for (;;) {
+		while (p!=e && (*p==' ' || *p=='\t' || *p=='\r' || *p=='\n'))
+			++p;
+		if (p==e)
+			return e;
+
+		switch (state) {
+		case NEXT:
+			if (*p==',') {
+				state = stack.back() ? KEY : VALUE;
+				++p;
+				continue;
 			}
-			break;
-		//case 16:  // after array end
-		//	goto accept_array;
-		case 17:  // after array element
-			switch (c) {
-			case ' ': case '\t': case '\r': case '\n':
-				break;
-			case ',':
-				//state=18;
-				array->push_back(JSON());
-				json_decode(in, array->back());
-				//state=17;
-				break;
-			case ']':
-				//state=16;
-				goto accept_array;
-			default:
-				throw runtime_error("JSON syntax error: expected ',' or ']' after array element");
+			if (*p!=(stack.back() ? '}' : ']')) {
+				if (stack.back())
+					throw runtime_error(json_fmt("%d: JSON syntax error: expected ',' or '}' after object key-value pair",(int)at(s,p)));
+				throw runtime_error(json_fmt("%d: JSON syntax error: expected ',' or ']' after array element",(int)at(s,p)));
 			}
+			goto close;
+		case COLON:
+			if (*p!=':')
+				throw runtime_error(json_fmt("%d: JSON syntax error: expected ':' after object key",(int)key_end));
+			state = VALUE;
+			++p;
+			continue;
+		case FIRST_KEY:
+			if (*p=='}')
+				goto close;
+			if (*p!='"')
+				throw runtime_error(json_fmt("%d: JSON syntax error: expected '}' or '\"' after object start",(int)at(s,p)));
 			break;
-		//case 18:  // after comma
-		//	in.unget();
-		//	array->push_back(JSON());
-		//	json_decode(in, array->back());
-		//	state=17;
-		//	break;
-
-		//
-		// OBJECT
-		//
-		case 19:  // after object begin
-			switch (c) {
-			case ' ': case '\t': case '\r': case '\n':
-				break;
-			case '}':
-				//state=20;
-				goto accept_object;
-			case '"':
-				in.unget();
-				json_decode(in, key);
-				if (key.type()!=JSON_STRING)
-					throw runtime_error("JSON key not string");
-				state=21;
-				break;
-			default:
-				throw runtime_error("JSON syntax error: expected '}' or '\"' after object start");
-			}
+		case KEY:
+			if (*p!='"')
+				throw runtime_error(json_fmt("%d: JSON syntax error: expected '\"' after comma in object",(int)at(s,p)));
 			break;
-		//case 20:  // after object end
-		//	goto accept_object;
-		case 21:  // after key
-			switch (c) {
-			case ' ': case '\t': case '\r': case '\n':
-				break;
-			case ':':
-				//state=22;
-				json_decode(in, (*object)[key.string()]);
-				state=23;
+		case FIRST_ELEMENT:
+			if (*p==']')
+				goto close;
+			// fall through
+		case VALUE:
+			switch (*p) {
+			case '[': case '{':
+				if (json_max_depth && stack.size() >= json_max_depth)
+					throw runtime_error(json_fmt("%d: JSON nesting too deep",(int)at(s,p)));
+				stack.push_back(*p=='{');
+				if (stack.back()) {
+					b.start_object();
+					state = FIRST_KEY;
+				} else {
+					b.start_array();
+					state = FIRST_ELEMENT;
+				}
+				++p;
+				continue;
+			case '"': case 'n': case 't': case 'f': case '-':
+			case '0': case '1': case '2': case '3': case '4':
+			case '5': case '6': case '7': case '8': case '9':
 				break;
 			default:
-				throw runtime_error("JSON syntax error: expected ':' after object key");
+				throw runtime_error(json_fmt("%d: JSON syntax error: invalid token",(int)at(s,p)));
 			}
 			break;
-		//case 22:
-		//	in.unget();
-		//	{ JSON& value = (*object)[key.string()];
-		//	json_decode(in, value); }
-		//	state=23;
-		//	break;
-		case 23:  // after value
-			switch (c) {
-			case ' ': case '\t': case '\r': case '\n':
-				break;
-			case ',':
-				state=24;
-				break;
-			case '}':
-				state=20;
-				goto accept_object;
-			default:
-				throw runtime_error("JSON syntax error: expected ',' or '}' after object key-value pair");
+		}
+
+		// a token: a key, or a string, number or literal value
+		const char *q;
+		if (*p=='"') {
+			escaped = false;
+			q = json_string_end(p+1, e, escaped);
+			cut = STRING;
+		} else if (*p=='n' || *p=='t' || *p=='f') {
+			size_t n = *p=='f' ? 5 : 4;
+			q = (size_t)(e-p) < n ? 0 : p+n;
+			cut = LITERAL;
+		} else {
+			number.start(*p);
+			q = number.scan(p, e);
+			cut = NUMBER;
+		}
+		if (!q) {
+			token.assign(p, e);
+			token_at = at(s,p);
+			return e;
+		}
+		cut = NONE;
+		if (take(p, q, e, at(s,p), out))
+			return q;
+		p = q;
+		continue;
+
+	close:
+		stack.pop_back();
+		if (*p=='}')
+			b.end_object();
+		else
+			b.end_array();
+		++p;
+		if (value(out))
+			return p;
+	}
+}
+
+void json_push_parser::feed(const char *s, size_t n, std::deque<JSON>& out) {
+	const char *e = s+n, *p = s;
+	if (word && n) {
+		if (*word && !json_delimiter(s, e))
+			throw runtime_error(json_fmt("%d: JSON syntax error: expected \"%s\"",(int)word_at,word));
+		if (!json_delimiter(s, e))
+			throw runtime_error(json_fmt("%d: JSON syntax error: unexpected character after number",(int)word_at));
+		word = 0;
+	}
+	if (cut)
+		p = resume(s, e, out);
+	while (p!=e) {
+		if (idle()) {
+			while (p!=e && (*p==' ' || *p=='\t' || *p=='\r' || *p=='\n'))
+				++p;
+			if (p==e)
+				break;
+			start = offset + (p-s);
+			json_value_end v;
+			v.start(*p);
+			const char *q = v.scan(p, e);
+			if (q) {  // all here
+				out.push_back(JSON());
+				try {
+					json_decode(p, q-p, out.back(), json_context());
+				} catch (...) {
+					out.pop_back();
+					throw;
+				}
+				p = q;
+				continue;
+			}
+		}
+		p = parse(s, p, e, out);
+	}
+	offset += n;
+}
+
+void json_push_parser::finish(std::deque<JSON>& out) {
+	if (cut) {  // a number at the end completes a value, and any other token throws its error
+		cut = NONE;
+		take(token.data(), token.data()+token.size(), token.data()+token.size(), token_at, out);
+	}
+	if (!idle())
+		throw runtime_error(json_fmt("%d: JSON invalid end of input",(int)(offset-start)));
+}
+
+JSONPushParser::JSONPushParser() : p(new json_push_parser()) {
+}
+JSONPushParser::~JSONPushParser() {
+	delete p;
+}
+void JSONPushParser::feed(const char *s, size_t n) {
+	p->feed(s, n, values);
+}
+void JSONPushParser::finish() {
+	p->finish(values);
+}
+void JSONPushParser::clear() {
+	json_push_parser *x = new json_push_parser();
+	delete p;
+	p = x;
+	values.clear();
+}
+
+
+//
+// parallel decoding: the input is cut into chunks after newlines, and worker
+// threads decode the values that start in each chunk; one that goes on past
+// the end of its chunk is followed to its end, and the next chunk, which then
+// started in the middle of it, is done again by the reader from there
+//
+struct json_chunk {  // what was decoded of a chunk
+	std::vector<JSON> values;
+	std::vector<std::pair<size_t,std::exception_ptr> > errors;  // in place of values[first]
+	size_t stop;  // where the next chunk should start: the end of this one, or of its last value
+};
+
+static void json_decode_chunk(const char *s, size_t from, size_t to, size_t n, json_chunk& out) {
+	// decodes the values that start in @from...@to of @s, the last of which
+	// may go on up to @n; after a syntax error, decoding goes on at the next
+	// line
+	out.values.clear();
+	out.errors.clear();
+	out.stop = to;
+	for (size_t p = from ; p < to ;) {
+		json_index i(s, n, p);
+		json_builder b(s, n, json_context());
+		size_t start = p;  // of the current value
+		try {
+			for (; !i.done() && (start = i.peek()) < to ;) {
+				const char *e = json_parse_value(s, n, i, b);
+				out.values.push_back(std::move(b.root));
+				if ((size_t)(e-s) > out.stop)
+					out.stop = e-s;
+			}
+			return;
+		} catch (...) {
+			out.values.push_back(JSON());
+			out.errors.push_back(std::make_pair(out.values.size()-1, std::current_exception()));
+		}
+		const char *nl = (const char*)memchr(s+start, '\n', n-start);
+		p = nl ? nl+1-s : n;
+		if (p > out.stop)
+			out.stop = p;
+	}
+}
+
+class json_batch {
+public:
+	enum { CHUNK=1<<20 };  // bytes of input per chunk, about
+
+	const char *s;
+	size_t n;
+	std::vector<size_t> starts;  // of the chunks, and the end of the input
+	size_t queue;  // chunks decoded ahead of the reader, at most
+
+	std::mutex m;
+	std::condition_variable cv;
+	size_t claimed, taken;  // chunks claimed by workers, and taken by the reader
+	std::vector<json_chunk> slots;  // chunk k is in slots[k % queue]
+	std::vector<char> ready;
+	bool stop;
+	std::vector<std::thread> threads;
+
+	json_chunk current;  // the reader's chunk
+	size_t value, error;  // the reader's next value and error in it
+	size_t expected;  // where the reader's next chunk should start
+
+	json_batch(const char *s, size_t n, unsigned nthreads);
+	inline ~json_batch() { join(); }
+	void join();
+	void work();
+	bool next(JSON& out);
+};
+
+json_batch::json_batch(const char *s, size_t n, unsigned nthreads)
+	: s(s), n(n), claimed(0), taken(0), stop(false), value(0), error(0), expected(0) {
+	for (size_t p = 0 ; p < n ;) {
+		starts.push_back(p);
+		p = p+CHUNK < n ? p+CHUNK : n;
+		const char *nl = (const char*)memchr(s+p, '\n', n-p);
+		p = nl ? nl+1-s : n;
+	}
+	starts.push_back(n);
+	current.stop = 0;
+
+	if (!nthreads)
+		nthreads = std::thread::hardware_concurrency();
+	if (!nthreads)
+		nthreads = 1;
+	if (nthreads > starts.size()-1)
+		nthreads = starts.size()-1;
+	queue = 2*(size_t)nthreads;
+	slots.resize(queue);
+	ready.assign(queue, 0);
+	try {
+		for (unsigned t = 0 ; t < nthreads ; ++t)
+			threads.push_back(std::thread(&json_batch::work, this));
+	} catch (...) {
+		join();
+		throw;
+	}
+}
+
+void json_batch::join() {  // stops the workers
+	{
+		std::lock_guard<std::mutex> l(m);
+		stop = true;
+	}
+	cv.notify_all();
+	for (size_t t = 0 ; t < threads.size() ; ++t)
+		threads[t].join();
+	threads.clear();
+}
+
+void json_batch::work() {
+	size_t chunks = starts.size()-1;
+	json_chunk c;
+	for (;;) {
+		size_t k;
+		{
+			std::unique_lock<std::mutex> l(m);
+			while (!stop && claimed < chunks && claimed >= taken+queue)
+				cv.wait(l);
+			if (stop || claimed==chunks)
+				return;
+			k = claimed++;
+		}
+		json_decode_chunk(s, starts[k], starts[k+1], n, c);
+		{
+			std::lock_guard<std::mutex> l(m);
+			slots[k % queue].values.swap(c.values);
+			slots[k % queue].errors.swap(c.errors);
+			slots[k % queue].stop = c.stop;
+			ready[k % queue] = 1;
+		}
+		cv.notify_all();
+	}
+}
+
+bool json_batch::next(JSON& out) {
+	size_t chunks = starts.size()-1;
+	for (;;) {
+		if (value < current.values.size()) {
+			size_t v = value++;
+			if (error < current.errors.size() && current.errors[error].first==v)
+				std::rethrow_exception(current.errors[error++].second);
+			out = std::move(current.values[v]);
+			return true;
+		}
+		if (taken==chunks)
+			return false;
+
+		size_t k;
+		{
+			std::unique_lock<std::mutex> l(m);
+			k = taken;
+			while (!ready[k % queue])
+				cv.wait(l);
+			current.values.swap(slots[k % queue].values);
+			current.errors.swap(slots[k % queue].errors);
+			current.stop = slots[k % queue].stop;
+			ready[k % queue] = 0;
+			++taken;
+		}
+		cv.notify_all();
+		value = error = 0;
+
+		if (expected!=starts[k]) {  // the last value of the previous chunk went on into this one
+			if (expected < starts[k+1]) {
+				json_decode_chunk(s, expected, starts[k+1], n, current);
+			} else {
+				current.values.clear();
+				current.errors.clear();
+				current.stop = expected;
+			}
+		}
+		expected = current.stop;
+	}
+}
+
+JSONParallelDecoder::JSONParallelDecoder(const char *s, size_t n, unsigned threads) : b(new json_batch(s, n, threads)) {
+}
+JSONParallelDecoder::JSONParallelDecoder(const std::string& in, unsigned threads) : b(new json_batch(in.data(), in.size(), threads)) {
+}
+JSONParallelDecoder::~JSONParallelDecoder() {
+	delete b;
+}
+bool JSONParallelDecoder::next(JSON& out) {
+	return b->next(out);
+}
+
+struct json_share {  // elements of a top-level array that one thread decodes
+	size_t from, to;  // after the '[' or ',' before them, and at the ',' or ']' after them
+	std::vector<uint32_t> pos;  // their structural positions, from @from, as stage 1 found them
+	bool indexed;  // false if @pos could not hold them, in a share of 4 GB or more
+	std::vector<JSON> elements;
+	std::exception_ptr error;
+};
+
+class json_share_index {  // the positions of a json_share, read as from a json_index
+	const uint32_t *p, *e;
+	size_t base;
+public:
+	json_share_index(const json_share& x) : p(x.pos.data()), e(x.pos.data() + x.pos.size()), base(x.from) { }
+	inline bool done() const { return p==e; }
+	inline size_t peek() const { return base + *p; }
+	inline size_t next() { return base + *p++; }
+};
+
+template <class Index>
+static void json_decode_elements(const char *s, size_t to, Index& i, std::vector<JSON>& out) {
+	// decodes the array elements at the positions of @i, up to @to
+	json_builder b(s, to, json_context());
+	for (;;) {
+		json_parse_value(s, to, i, b);
+		out.push_back(std::move(b.root));
+		if (i.done())
+			return;
+		size_t p = i.next();
+		if (s[p]!=',')
+			throw runtime_error(json_fmt("%d: JSON syntax error: expected ',' or ']' after array element",(int)p));
+	}
+}
+
+class json_shares {  // the shares of an array, decoded by workers as stage 1 hands them out
+public:
+	const char *s;
+	size_t queue;  // shares handed out and not yet decoded, at most, before stage 1 decodes one itself
+
+	std::mutex m;
+	std::condition_variable cv;
+	std::deque<json_share> shares;  // stable addresses
+	size_t closed, claimed;  // shares that stage 1 has handed out, and that threads have taken
+	bool stop;  // no more shares will be handed out
+	std::vector<std::thread> threads;
+
+	json_shares(const char *s) : s(s), queue(0), closed(0), claimed(0), stop(false) { }
+	inline ~json_shares() { join(true); }
+
+	json_share *open(size_t from);
+	void close(json_share *x, size_t to, unsigned nthreads);
+	void end();
+	void join(bool abandon);
+	bool decode();
+	inline void work() { while (decode()) { } }
+};
+
+json_share *json_shares::open(size_t from) {  // only stage 1 adds and fills shares
+	std::lock_guard<std::mutex> l(m);
+	shares.push_back(json_share());
+	json_share *x = &shares.back();
+	x->from = from;
+	x->indexed = true;
+	return x;
+}
+void json_shares::close(json_share *x, size_t to, unsigned nthreads) {
+	x->to = to;
+	bool backlog;
+	{
+		std::lock_guard<std::mutex> l(m);
+		++closed;
+		backlog = queue && closed-claimed > queue;
+	}
+	cv.notify_one();
+	if (!queue && closed==1) {  // the first share is out and there is more: start the workers
+		queue = 2*(size_t)nthreads;
+		try {
+			for (unsigned t = 1 ; t < nthreads ; ++t)
+				threads.push_back(std::thread(&json_shares::work, this));
+		} catch (std::system_error&) {  // fewer threads, then
+		}
+	} else if (backlog) {  // stage 1 is ahead of the workers; keep the positions it holds bounded
+		decode();
+	}
+}
+void json_shares::end() {  // no more shares: the workers stop when the last is taken
+	{
+		std::lock_guard<std::mutex> l(m);
+		stop = true;
+	}
+	cv.notify_all();
+}
+void json_shares::join(bool abandon) {  // waits for the workers; with @abandon, after the shares they are on
+	{
+		std::lock_guard<std::mutex> l(m);
+		stop = true;
+		if (abandon)
+			closed = claimed;
+	}
+	cv.notify_all();
+	for (size_t t = 0 ; t < threads.size() ; ++t)
+		threads[t].join();
+	threads.clear();
+}
+bool json_shares::decode() {  // decodes the next share handed out; false if there will be none
+	json_share *x;
+	{
+		std::unique_lock<std::mutex> l(m);
+		while (!stop && claimed==closed)
+			cv.wait(l);
+		if (claimed==closed)
+			return false;
+		x = &shares[claimed++];
+	}
+	try {
+		if (x->indexed) {
+			json_share_index i(*x);
+			json_decode_elements(s, x->to, i, x->elements);
+		} else {
+			json_index i(s, x->to, x->from);
+			json_decode_elements(s, x->to, i, x->elements);
+		}
+	} catch (...) {
+		x->error = std::current_exception();
+	}
+	std::vector<uint32_t>().swap(x->pos);
+	return true;
+}
+
+void json_decode_parallel(const char *s, size_t n, JSON& out, unsigned threads) {
+	// stage 1 runs once over the input, on this thread; it cuts the elements
+	// into shares at commas of the top level, about a chunk apart, keeping
+	// the positions it finds in each, and hands every share to the workers
+	// as soon as it is complete; the workers check everything else
+	json_index i(s, n);
+	if (i.done() || s[i.peek()]!='[') {
+		json_decode(s, n, out, json_context());
+		return;
+	}
+
+	if (!threads)
+		threads = std::thread::hardware_concurrency();
+	if (!threads)
+		threads = 1;
+	json_shares w(s);
+	json_share *x = 0;
+	bool ended = false;
+	size_t depth = 0;
+	while (!i.done()) {
+		size_t p = i.next();
+		switch (s[p]) {
+		case '[': case '{':
+			if (json_max_depth && depth >= json_max_depth)
+				throw runtime_error(json_fmt("%d: JSON nesting too deep",(int)p));
+			if (!depth++) {
+				x = w.open(p+1);
+				continue;
 			}
 			break;
-		case 24:  // after comma
-			switch (c) {
-			case ' ': case '\t': case '\r': case '\n':
-				break;
-			case '"':
-				in.unget();
-				json_decode(in, key);
-				if (key.type()!=JSON_STRING)
-					throw runtime_error("JSON key not string");
-				state=21;
-				break;
-			default:
-				throw runtime_error("JSON syntax error: expected '\"' after comma in object");
+		case ']': case '}':
+			if (--depth)
+				break;
+			if (s[p]!=']')
+				throw runtime_error(json_fmt("%d: JSON syntax error: expected ',' or ']' after array element",(int)p));
+			if (!i.done())
+				throw runtime_error(json_fmt("%d: JSON syntax error",(int)i.peek()));
+			ended = true;
+			if (w.closed)  // otherwise it is all one share, decoded as by json_decode() below
+				w.close(x, p, threads);
+			continue;
+		case ',':
+			if (depth==1 && p-x->from >= json_batch::CHUNK) {
+				w.close(x, p, threads);
+				x = w.open(p+1);
+				continue;
 			}
 			break;
 		}
+		if (!x->indexed)
+			continue;
+		if (p-x->from > (uint32_t)-1) {
+			x->indexed = false;
+			std::vector<uint32_t>().swap(x->pos);
+			continue;
+		}
+		x->pos.push_back((uint32_t)(p-x->from));
+	}
+	if (!ended || !w.closed) {  // an array that does not end, for its error, or a small one
+		w.join(true);
+		json_decode(s, n, out, json_context());
+		return;
+	}
+	w.end();
+	w.work();  // along with the workers
+	w.join(false);
+
+	size_t count = 0;
+	for (size_t k = 0 ; k < w.shares.size() ; ++k) {
+		if (w.shares[k].error)
+			std::rethrow_exception(w.shares[k].error);
+		count += w.shares[k].elements.size();
+	}
+	JSONArray *array = json_new_array(0);
+	out.set(array);
+	array->reserve(count);
+	for (size_t k = 0 ; k < w.shares.size() ; ++k) {
+		std::vector<JSON>& elements = w.shares[k].elements;
+		for (size_t e = 0 ; e < elements.size() ; ++e)
+			array->push_back(std::move(elements[e]));
+		std::vector<JSON>().swap(elements);
 	}
+}
+void json_decode_file_parallel(const char *path, JSON& out, unsigned threads) {
+	json_mapping file(path);
+	json_decode_parallel(file.data(),file.length(),out,threads);
+}
 
-	switch (state) {
 
-	accept_null: case 1:
-		out.set(0);
-		break;
+//
+// extraction by JSON Pointer: the input is walked only along the pointers,
+// and every other value is skipped by its quotes and brackets
+//
+static inline const char *json_skip_space(const char *p, const char *end) {
+	while (p!=end && (*p==' ' || *p=='\t' || *p=='\r' || *p=='\n'))
+		++p;
+	return p;
+}
 
-	accept_true: case 2:
-		out = true;
-		break;
+static void json_pointer_tokens(const std::string& pointer, std::vector<std::string>& out) {
+	// the reference tokens of @pointer, with ~0 and ~1 undone
+	if (!pointer.empty() && pointer[0]!='/')
+		throw runtime_error(json_fmt("invalid JSON pointer %s",json_encode(JSONString(pointer)).c_str()));
+	for (size_t i = 0 ; i < pointer.size() ; ) {
+		size_t j = pointer.find('/', i+1);
+		if (j==std::string::npos)
+			j = pointer.size();
+		std::string token;
+		for (size_t k = i+1 ; k < j ; ++k) {
+			if (pointer[k]!='~') {
+				token += pointer[k];
+			} else if (k+1 < j && (pointer[k+1]=='0' || pointer[k+1]=='1')) {
+				token += pointer[++k]=='0' ? '~' : '/';
+			} else {
+				throw runtime_error(json_fmt("invalid JSON pointer %s",json_encode(JSONString(pointer)).c_str()));
+			}
+		}
+		out.push_back(token);
+		i = j;
+	}
+}
 
-	accept_false: case 3:
-		out = false;
-		break;
+static size_t json_pointer_index(const std::string& token) {
+	// the array index @token refers to, or -1 when it refers to none
+	if (token.empty() || token.size() > 18 || (token[0]=='0' && token.size() > 1))
+		return (size_t)-1;
+	size_t i = 0;
+	for (size_t k = 0 ; k < token.size() ; ++k) {
+		if (token[k]<'0' || token[k]>'9')
+			return (size_t)-1;
+		i = i*10 + (token[k]-'0');
+	}
+	return i;
+}
 
-	accept_number: case 5: case 6: case 8: case 11: {
-		const char *startp=number.c_str();
-		char *endp=0;
-		double v = strtod(startp,&endp);
-		if (startp==endp)
-			throw runtime_error("JSON number does not parse");
-		out = v;
-		} break;
+struct json_extractor {
+	const char *s, *end;
+	std::vector<std::vector<std::string> > tokens;  // of each pointer
+	std::vector<std::vector<size_t> > indexes;  // of each pointer, as json_pointer_index() gives them
+	std::vector<JSON> *out;
+	std::vector<bool> found;
+	size_t left;  // pointers not found yet
+	size_t objects;  // being walked, which may still repeat a key that was followed
+
+	json_extractor(const char *s, size_t n, const std::vector<std::string>& pointers, std::vector<JSON>& out);
+
+	const char *skip(const char *p);
+	const char *decode(const char *p, JSON& out);
+	const char *value(const char *p, size_t depth, const std::vector<size_t>& active);
+	inline bool done() const { return !left && !objects; }
+};
+
+json_extractor::json_extractor(const char *s, size_t n, const std::vector<std::string>& pointers, std::vector<JSON>& out)
+	: s(s), end(s+n), tokens(pointers.size()), indexes(pointers.size()), out(&out), found(pointers.size()), left(pointers.size()), objects(0) {
+	for (size_t k = 0 ; k < pointers.size() ; ++k) {
+		json_pointer_tokens(pointers[k], tokens[k]);
+		for (size_t t = 0 ; t < tokens[k].size() ; ++t)
+			indexes[k].push_back(json_pointer_index(tokens[k][t]));
+	}
+	out.assign(pointers.size(), JSON());
+}
 
-	accept_string: case 13:
-		out = *str;
-		delete str; str = 0;
-		break;
+const char *json_extractor::skip(const char *p) {
+	// the end of the value at @p, which is only checked as far as it takes
+	// to find it
+	switch (*p) {
+	case '"': case '[': case '{': {
+		json_value_end value;
+		value.start(*p);
+		const char *q = value.scan(p, end);
+		if (!q)
+			throw runtime_error(json_fmt("%d: JSON invalid end of input",(int)(end-s)));
+		return q;
+		}
+	case 'n':
+		if (end-p<4 || strncmp(p,"null",4)!=0 || !json_delimiter(p+4,end))
+			throw runtime_error(json_fmt("%d: JSON syntax error: expected \"null\"",(int)(p-s)));
+		return p+4;
+	case 'f':
+		if (end-p<5 || strncmp(p,"false",5)!=0 || !json_delimiter(p+5,end))
+			throw runtime_error(json_fmt("%d: JSON syntax error: expected \"false\"",(int)(p-s)));
+		return p+5;
+	case 't':
+		if (end-p<4 || strncmp(p,"true",4)!=0 || !json_delimiter(p+4,end))
+			throw runtime_error(json_fmt("%d: JSON syntax error: expected \"true\"",(int)(p-s)));
+		return p+4;
+	case '-':
+	case '0': case '1': case '2': case '3': case '4':
+	case '5': case '6': case '7': case '8': case '9':
+		return json_scan_number(s, p, end);
+	default:
+		throw runtime_error(json_fmt("%d: JSON syntax error: invalid token",(int)(p-s)));
+	}
+}
 
-	accept_array: case 16:
-		out.set(array);
-		break;
-	
-	accept_object: case 20:
-		out.set(object);
-		break;
+const char *json_extractor::decode(const char *p, JSON& out) {
+	json_index i(s, end-s, p-s);
+	json_builder b(s, end-s, json_context());
+	const char *q = json_parse_value(s, end-s, i, b);
+	out = std::move(b.root);
+	return q;
+}
 
-	default:
-		throw runtime_error("JSON no token");
+const char *json_extractor::value(const char *p, size_t depth, const std::vector<size_t>& active) {
+	// walks the value at @p for the @active pointers, whose first @depth
+	// tokens lead to it; returns its end, or 0 once every pointer is found
+	// for good
+	if (p==end)
+		throw runtime_error(json_fmt("%d: JSON invalid end of input",(int)(end-s)));
+	const char *q = 0;  // the end, once the value is decoded
+	size_t first = 0;  // the pointer it is decoded for
+	bool deeper = false;
+	for (size_t a = 0 ; a < active.size() ; ++a) {
+		size_t k = active[a];
+		if (tokens[k].size() > depth) {
+			deeper = true;
+			continue;
+		}
+		if (q) {
+			(*out)[k] = (*out)[first];
+		} else {
+			q = decode(p, (*out)[k]);
+			first = k;
+		}
+		found[k] = true;
+		--left;
+	}
+	if (done())
+		return 0;
+	if (!deeper || (*p!='[' && *p!='{'))
+		return q ? q : skip(p);
+
+	std::vector<size_t> next;
+	if (*p=='[') {
+		p = json_skip_space(p+1, end);
+		if (p!=end && *p==']')
+			return p+1;
+		for (size_t i = 0 ; ; ++i) {
+			next.clear();
+			for (size_t a = 0 ; a < active.size() ; ++a)
+				if (tokens[active[a]].size() > depth && indexes[active[a]][depth]==i)
+					next.push_back(active[a]);
+			if (p==end)
+				throw runtime_error(json_fmt("%d: JSON invalid end of input",(int)(end-s)));
+			p = next.empty() ? skip(p) : value(p, depth+1, next);
+			if (!p || done())
+				return 0;
+			p = json_skip_space(p, end);
+			if (p==end)
+				throw runtime_error(json_fmt("%d: JSON invalid end of input",(int)(end-s)));
+			if (*p==']')
+				return p+1;
+			if (*p!=',')
+				throw runtime_error(json_fmt("%d: JSON syntax error: expected ',' or ']' after array element",(int)(p-s)));
+			p = json_skip_space(p+1, end);
+		}
+	}
+
+	// of repeated keys the last counts, as in json_decode(), so the object is
+	// walked to its end even once every pointer is found in it
+	std::string buf;
+	const char *str;
+	size_t len;
+	p = json_skip_space(p+1, end);
+	if (p!=end && *p=='}')
+		return p+1;
+	++objects;
+	for (bool first = true ; ; first = false) {
+		if (p==end)
+			throw runtime_error(json_fmt("%d: JSON invalid end of input",(int)(end-s)));
+		if (*p!='"' && first)
+			throw runtime_error(json_fmt("%d: JSON syntax error: expected '}' or '\"' after object start",(int)(p-s)));
+		if (*p!='"')
+			throw runtime_error(json_fmt("%d: JSON syntax error: expected '\"' after comma in object",(int)(p-s)));
+		p = json_skip_space(json_scan_string(s, p, end, buf, str, len), end);
+		if (p==end)
+			throw runtime_error(json_fmt("%d: JSON invalid end of input",(int)(end-s)));
+		if (*p!=':')
+			throw runtime_error(json_fmt("%d: JSON syntax error: expected ':' after object key",(int)(p-s)));
+		p = json_skip_space(p+1, end);
+		next.clear();
+		for (size_t a = 0 ; a < active.size() ; ++a) {
+			const std::vector<std::string>& t = tokens[active[a]];
+			if (t.size() > depth && t[depth].size()==len && memcmp(t[depth].data(), str, len)==0)
+				next.push_back(active[a]);
+		}
+		for (size_t a = 0 ; a < next.size() ; ++a) {
+			if (found[next[a]]) {  // under an earlier member of the same key
+				found[next[a]] = false;
+				(*out)[next[a]] = JSON();
+				++left;
+			}
+		}
+		if (p==end)
+			throw runtime_error(json_fmt("%d: JSON invalid end of input",(int)(end-s)));
+		p = next.empty() ? skip(p) : value(p, depth+1, next);
+		p = json_skip_space(p, end);
+		if (p==end)
+			throw runtime_error(json_fmt("%d: JSON invalid end of input",(int)(end-s)));
+		if (*p=='}') {
+			--objects;
+			return p+1;
+		}
+		if (*p!=',')
+			throw runtime_error(json_fmt("%d: JSON syntax error: expected ',' or '}' after object key-value pair",(int)(p-s)));
+		p = json_skip_space(p+1, end);
 	}
 }
+
+size_t json_extract(const char *s, size_t n, const std::vector<std::string>& pointers, std::vector<JSON>& out) {
+	json_extractor x(s, n, pointers, out);
+	std::vector<size_t> all;
+	for (size_t k = 0 ; k < pointers.size() ; ++k)
+		all.push_back(k);
+	if (!pointers.empty())
+		x.value(json_skip_space(s, s+n), 0, all);
+	return pointers.size() - x.left;
+}
+
+bool json_extract(const char *s, size_t n, const std::string& pointer, JSON& out) {
+	std::vector<JSON> values;
+	if (!json_extract(s, n, std::vector<std::string>(1, pointer), values))
+		return false;
+	out = std::move(values[0]);
+	return true;
+}
+
+JSON json_extract(const std::string& in, const std::string& pointer) {
+	JSON out;
+	if (!json_extract(in.data(), in.size(), pointer, out))
+		throw std::out_of_range(json_fmt("JSON has no value at %s",json_encode(JSONString(pointer)).c_str()));
+	return out;
+}
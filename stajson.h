@@ -3,9 +3,17 @@
 //
 // - stores std::string strings
 // - intended to be used with UTF-8 encoded data or single-byte encodings
-// - does not preserve order of {} object members
-// - JSONArray and JSONObject types are based on std::vector and std::map, and work the same way
-// - no reference-counting or garbage-collection, even for object and array types
+// - does not preserve order of {} object members, unless STAJSON_ORDERED_OBJECTS is defined
+// - JSONArray and JSONObject types are based on std::vector and std::map, and work the same way;
+//   objects with few members keep them in flat slots (JSONSmallMap) instead of a tree, and
+//   references to them stay valid until a member past JSONSmallMap::SMALL is added, and
+//   iterators too, but not through a swap() or a move of the object;
+//   with STAJSON_ORDERED_OBJECTS, JSONObject is based on JSONOrderedMap, a hash map that keeps
+//   members in insertion order, in an array that insertion can move as a vector's
+//   (define it for the library and its users alike)
+// - no reference-counting or garbage-collection, unless asked for: after JSON::share(), copies
+//   share strings, arrays and objects, and a copy is only made when one of them is modified;
+//   a node that a non-const accessor has handed out a reference into is no longer shared
 // - type errors are derived from runtime_error, since data normally comes from outside sources
 // - NOT thread-safe; hold a lock before doing anything
 //
@@ -19,12 +27,24 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <deque>
 #include <stdexcept>
 #include <stdlib.h>
 #include <ctype.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <iostream>
+#include <new>
+#include <utility>
+#include <type_traits>
+#include <iterator>
+#include <algorithm>
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
 
 
 enum JSONType {
@@ -42,51 +62,224 @@ class JSONNumber;
 class JSONString;
 class JSONArray;
 class JSONObject;
+class JSONDocument;
 
 
 //
 // data is tagged with a JSONType
 //
 class JSONBase {
-	JSONType t;
+	friend class JSON;
+	friend class JSONArena;
+
+	unsigned char t;  // JSONType
+	unsigned char f;  // flags
+	mutable std::atomic<unsigned> refs;  // references to a SHARED node, besides the first; copies on
+	                                     // different threads change it, though they look independent
 protected:
-	inline JSONBase(JSONType type) : t(type) { }
+	inline JSONBase(JSONType type, unsigned char flags=0) : t(type), f(flags), refs(0) { }
+	inline void flag(unsigned char x, bool on) { f = on ? f | x : f & ~x; }
 public:
+	enum {
+		ARENA=1,  // lives in a JSONArena; delete does nothing
+		SHARED=2,  // copied by reference, until modified
+		INTEGER=4  // a JSONNumber that holds an int64_t rather than a double
+	};
+
 	inline static void operator delete(void *p);
 
-	inline JSONType type() const { return t; }
+	inline JSONType type() const { return (JSONType)t; }
+	inline unsigned flags() const { return f; }
 
 	inline JSONBase *copy();
+
+	template <class T, class... Args>
+	inline static T *make(Args&&... args);  // new T(args...), outside any arena
+	inline static void destroy(JSONBase *p);  // delete p, for a node from make() or new
+};
+
+
+//
+// monotonic memory arena: allocating is a pointer bump, and all memory is
+// given back at once by release(), without visiting the nodes
+//
+class JSONArena {
+	struct Block {
+		Block *next;
+	};
+	struct Cleanup {
+		void (*f)(void *);
+		void *p;
+		Cleanup *next;
+	};
+
+	char *pos;
+	char *end;
+	Block *blocks;
+	Cleanup *cleanups;
+	size_t next;  // size of the next block
+
+	void *grow(size_t n, size_t align);
+
+	JSONArena(const JSONArena&);
+	JSONArena& operator=(const JSONArena&);
+public:
+	inline JSONArena() : pos(0), end(0), blocks(0), cleanups(0), next(4096) { }
+	inline ~JSONArena() { release(); }
+
+	inline void *allocate(size_t n, size_t align);
+
+	template <class T, class... Args>
+	inline T *make(Args&&... args);  // constructs a JSONBase node flagged ARENA
+	template <class T>
+	inline void own(T *p);  // the destructor of @p runs on release()
+
+	void release();
+};
+
+
+//
+// STL allocator for JSONArray and JSONObject storage; allocates from a
+// JSONArena, or from the heap if there is none
+//
+template <class T>
+class JSONAllocator {
+public:
+	typedef T value_type;
+	typedef std::true_type propagate_on_container_move_assignment;
+	typedef std::true_type propagate_on_container_swap;
+
+	JSONArena *arena;
+
+	inline JSONAllocator(JSONArena *a=0) noexcept : arena(a) { }
+	template <class U>
+	inline JSONAllocator(const JSONAllocator<U>& x) noexcept : arena(x.arena) { }
+
+	inline T *allocate(size_t n) {
+		if (arena) return (T*)arena->allocate(n*sizeof(T), alignof(T));
+		return (T*)::operator new(n*sizeof(T));
+	}
+	inline void deallocate(T *p, size_t) {
+		if (!arena) ::operator delete(p);
+	}
+
+	// copies never share the arena of the original
+	inline JSONAllocator select_on_container_copy_construction() const { return JSONAllocator(); }
+
+	template <class U>
+	inline bool operator==(const JSONAllocator<U>& x) const { return arena==x.arena; }
+	template <class U>
+	inline bool operator!=(const JSONAllocator<U>& x) const { return arena!=x.arena; }
+};
+
+
+//
+// the scalar JSON types; JSON values hold these inline, without allocating
+//
+class JSONBool : public JSONBase {
+	bool v;
+public:
+	inline JSONBool() : JSONBase(JSON_BOOLEAN), v(false) { }
+	inline JSONBool(bool value) : JSONBase(JSON_BOOLEAN), v(value) { }
+	inline JSONBool(const JSONBool& x) : JSONBase(JSON_BOOLEAN), v(x.v) { }
+
+	inline bool value() const { return v; }
+	inline operator bool() const { return v; }
 };
+typedef JSONBool JSONBoolean;
+
+class JSONNumber : public JSONBase {
+	union {
+		double v;
+		int64_t i;  // INTEGER
+	};
+public:
+	inline JSONNumber() : JSONBase(JSON_NUMBER), v(0.0) { }
+	inline JSONNumber(double value) : JSONBase(JSON_NUMBER), v(value) { }
+	inline JSONNumber(int value) : JSONBase(JSON_NUMBER, INTEGER), i(value) { }
+	inline JSONNumber(int64_t value) : JSONBase(JSON_NUMBER, INTEGER), i(value) { }
+	inline JSONNumber(const JSONNumber& x) : JSONBase(JSON_NUMBER, x.flags() & INTEGER) { if (x.integer()) i = x.i; else v = x.v; }
+	inline JSONNumber& operator=(const JSONNumber& x) {  // the value only, not where this node lives
+		flag(INTEGER, x.integer());
+		if (x.integer()) i = x.i; else v = x.v;
+		return *this;
+	}
 
+	inline bool integer() const { return flags() & INTEGER; }
+	inline int64_t int64() const {  // if not integer(), truncated, clamped to the range, and 0 for NaN
+		if (integer()) return i;
+		if (v >= 9223372036854775808.0) return INT64_MAX;  // 2^63
+		if (v >= -9223372036854775808.0) return (int64_t)v;
+		return v < 0 ? INT64_MIN : 0;
+	}
+	inline double value() const { return integer() ? (double)i : v; }
+	inline operator double() const { return value(); }
+};
 
 //
-// JSON is a simple pointer-holding class, with "syntactic sugar"
+// JSON is a tagged value, with "syntactic sugar"; null, booleans and numbers
+// are stored inline, strings, arrays and objects are pointers to heap nodes
 //
 class JSON {
-	JSONBase *p;
+	class Ref : public JSONBase {
+	public:
+		JSONBase *p;
+		inline Ref() : JSONBase(JSON_NULL), p(0) { }  // null
+		inline Ref(JSONBase *pp) : JSONBase(pp->type()), p(pp) { }
+	};
+
+	// one node, made by placement new: a JSONBool, a JSONNumber, or a Ref for
+	// strings, arrays, objects, and null with a null pointer; all of them
+	// begin with their JSONBase, which holds the type
+	alignas(JSONNumber) unsigned char d[sizeof(JSONNumber)];
+	template <class T> inline T& as() { return *reinterpret_cast<T*>(d); }
+	template <class T> inline const T& as() const { return *reinterpret_cast<const T*>(d); }
+	inline JSONBase *node() const { return as<Ref>().p; }  // if boxed()
+
+	inline bool boxed() const;  // holds a pointer
+	inline static JSONBase *hold(JSONBase *p);
+	inline static void release(JSONBase *p);
+	inline void unshare();
+	inline void clear();
+	inline void box(JSONBase *pp);
+	inline void assign(const JSON& x);
+	inline void take(JSON& x);
 public:
 	inline JSON();
 	inline JSON(bool v);
 	inline JSON(double v);
+	inline JSON(int v);
+	inline JSON(int64_t v);
 	inline JSON(const char *v);
 	inline JSON(const std::string& v);
 	inline JSON(const JSONArray& x);
 	inline JSON(const JSONObject& x);
 	inline JSON(const JSON& x);
+	inline JSON(std::string&& v);
+	inline JSON(JSONArray&& x);
+	inline JSON(JSONObject&& x);
+	inline JSON(JSON&& x) noexcept;
 	inline ~JSON();
 
 	inline JSON& operator=(bool v);
 	inline JSON& operator=(double v);
+	inline JSON& operator=(int v);
+	inline JSON& operator=(int64_t v);
 	inline JSON& operator=(const char *v);
 	inline JSON& operator=(const std::string& v);
 	inline JSON& operator=(const JSONArray& x);
 	inline JSON& operator=(const JSONObject& x);
 	inline JSON& operator=(const JSON& x);
+	inline JSON& operator=(std::string&& v);
+	inline JSON& operator=(JSONArray&& x);
+	inline JSON& operator=(JSONObject&& x);
+	inline JSON& operator=(JSON&& x) noexcept;
 
 	inline JSONBase *get();
 	inline const JSONBase *get() const;
-	inline void set(JSONBase *pp);  // takes ownership; do not delete @pp later; previous @p is deleted
+	inline void set(JSONBase *pp);  // takes ownership; do not delete @pp later; previous value is deleted
+
+	void share();  // copies of this value and of its members will share nodes, until modified
 
 	inline JSONType type() const;
 
@@ -101,10 +294,10 @@ public:
 	inline const JSONObject& object() const;
 	inline JSONObject& object();
 
-	inline bool has(int i);
-	inline bool has(size_t i);
-	inline bool has(const char *s);
-	inline bool has(const std::string& s);
+	inline bool has(int i) const;
+	inline bool has(size_t i) const;
+	inline bool has(const char *s) const;
+	inline bool has(const std::string& s) const;
 
 	inline JSON& get(int i);
 	inline const JSON& get(int i) const;
@@ -119,6 +312,10 @@ public:
 	inline JSON& operator[](size_t i);
 	inline JSON& operator[](const char *s);
 	inline JSON& operator[](const std::string& s);
+	inline const JSON& operator[](int i) const;  // const versions do not add members
+	inline const JSON& operator[](size_t i) const;
+	inline const JSON& operator[](const char *s) const;
+	inline const JSON& operator[](const std::string& s) const;
 
 	inline operator bool() const;
 	inline operator double() const;
@@ -127,55 +324,48 @@ public:
 
 
 //
-// the 5 JSON types
+// the 5 JSON types (JSON_NULL has no class of its own)
 //
-class JSONBool : public JSONBase {
-	bool v;
-public:
-	inline JSONBool() : JSONBase(JSON_BOOLEAN), v(false) { }
-	inline JSONBool(bool value) : JSONBase(JSON_BOOLEAN), v(value) { }
-	inline JSONBool(const JSONBool& x) : JSONBase(JSON_BOOLEAN), v(x.v) { }
-
-	inline bool value() const { return v; }
-	inline operator bool() const { return v; }
-};
-typedef JSONBool JSONBoolean;
-
-class JSONNumber : public JSONBase {
-	double v;
-public:
-	inline JSONNumber() : JSONBase(JSON_NUMBER), v(0.0) { }
-	inline JSONNumber(double value) : JSONBase(JSON_NUMBER), v(value) { }
-	inline JSONNumber(const JSONNumber& x) : JSONBase(JSON_NUMBER), v(x.v) { }
-
-	inline double value() const { return v; }
-	inline operator double() const { return v; }
-};
-
 class JSONString : public JSONBase {
-	std::string v;
-public:
-	inline JSONString() : JSONBase(JSON_STRING), v("") { }
-	inline JSONString(const JSONString& x) : JSONBase(JSON_STRING), v(x.v) { }
-	inline JSONString(const char *value) : JSONBase(JSON_STRING), v(value) { }
-	inline JSONString(const std::string& value) : JSONBase(JSON_STRING), v(value) { }
-
-	inline operator const char*() const { return v.c_str(); }
-	inline const std::string& value() const { return v; }
-	inline operator const std::string&() const { return v; }
+	mutable std::string v;
+	mutable const char *p;  // borrowed characters, not yet copied into v; or 0
+	size_t n;
 
-	inline const char *c_str() const { return v.c_str(); }
+	inline const std::string& str() const { if (p) { v.assign(p,n); p = 0; } return v; }
+public:
+	inline JSONString() : JSONBase(JSON_STRING), v(""), p(0), n(0) { }
+	inline JSONString(const JSONString& x) : JSONBase(JSON_STRING), v(x.str()), p(0), n(0) { }
+	inline JSONString(const char *value) : JSONBase(JSON_STRING), v(value), p(0), n(0) { }
+	inline JSONString(const std::string& value) : JSONBase(JSON_STRING), v(value), p(0), n(0) { }
+	inline JSONString(JSONString&& x) : JSONBase(JSON_STRING), v(std::move(x.v)), p(x.p), n(x.n) { }
+	inline JSONString(std::string&& value) : JSONBase(JSON_STRING), v(std::move(value)), p(0), n(0) { }
+	// with @borrow, the string refers to the @n characters at @s until they
+	// are needed as a std::string, even by a const reader, so that two
+	// readers of one const borrowed string race; they must outlive it
+	inline JSONString(const char *s, size_t n, bool borrow=false)
+		: JSONBase(JSON_STRING), v(borrow ? std::string() : std::string(s,n)), p(borrow ? s : 0), n(n) { }
+
+	inline operator const char*() const { return str().c_str(); }
+	inline const std::string& value() const { return str(); }
+	inline operator const std::string&() const { return str(); }
+
+	inline const char *c_str() const { return str().c_str(); }
+	inline const char *data() const { return p ? p : v.data(); }  // not NUL-terminated
+	inline size_t size() const { return p ? n : v.size(); }
+	inline bool borrowed() const { return p!=0; }
 };
 
 class JSONArray : public JSONBase {
-	std::vector<JSON> v;
+	typedef std::vector<JSON,JSONAllocator<JSON> > vector_type;
+	vector_type v;
 public:
+	typedef JSONAllocator<JSON> allocator_type;
 	typedef JSON value_type;
 	typedef value_type *pointer;
 	typedef value_type& reference;
 	typedef const value_type& const_reference;
-	typedef std::vector<JSON>::size_type size_type;
-	typedef std::vector<JSON>::difference_type difference_type;
+	typedef vector_type::size_type size_type;
+	typedef vector_type::difference_type difference_type;
 private:
 	template <typename ITER, typename ELEM>
 	class iterator_t {
@@ -211,19 +401,22 @@ private:
 		void swap(iterator& x) { swap(i,x.i); }
 	};
 public:
-	typedef iterator_t<std::vector<JSON>::iterator,JSON> iterator;
-	typedef iterator_t<std::vector<JSON>::reverse_iterator,JSON> reverse_iterator;
-	typedef iterator_t<std::vector<JSON>::const_iterator,const JSON> const_iterator;
-	typedef iterator_t<std::vector<JSON>::const_reverse_iterator,const JSON> const_reverse_iterator;
+	typedef iterator_t<vector_type::iterator,JSON> iterator;
+	typedef iterator_t<vector_type::reverse_iterator,JSON> reverse_iterator;
+	typedef iterator_t<vector_type::const_iterator,const JSON> const_iterator;
+	typedef iterator_t<vector_type::const_reverse_iterator,const JSON> const_reverse_iterator;
 
 	inline JSONArray() : JSONBase(JSON_ARRAY) { }
+	inline explicit JSONArray(const allocator_type& a) : JSONBase(JSON_ARRAY), v(a) { }
 	inline JSONArray(size_type n) : JSONBase(JSON_ARRAY), v(n) { }
 	inline JSONArray(size_type n, const_reference t) : JSONBase(JSON_ARRAY), v(n, t) { }
 	inline JSONArray(const JSONArray& x) : JSONBase(JSON_ARRAY), v(x.v) { }
+	inline JSONArray(JSONArray&& x) noexcept : JSONBase(JSON_ARRAY), v(std::move(x.v)) { }
 	template <class InputIterator>
 	inline JSONArray(InputIterator a, InputIterator b) : JSONBase(JSON_ARRAY), v(a,b) { } 
 
 	inline JSONArray& operator=(const JSONArray& x) { v=x.v; return *this; }
+	inline JSONArray& operator=(JSONArray&& x) noexcept { v=std::move(x.v); return *this; }
 
 	inline iterator begin() { return v.begin(); }
 	inline iterator end() { return v.end(); }
@@ -250,6 +443,9 @@ public:
 	inline reference back() { return v.back(); }
 	inline const_reference back() const { return v.back(); }
 	inline void push_back(const_reference x) { v.push_back(x); }
+	inline void push_back(value_type&& x) { v.push_back(std::move(x)); }
+	template <class... Args>
+	inline reference emplace_back(Args&&... args) { v.emplace_back(std::forward<Args>(args)...); return v.back(); }
 	inline void pop_back() { v.pop_back(); }
 	inline void swap(JSONArray& x) { v.swap(x.v); }
 
@@ -258,7 +454,10 @@ public:
 	inline iterator insert(iterator pos, const char *x) { return v.insert(pos.i, JSON(x)); }
 	inline iterator insert(iterator pos, const std::string& x) { return v.insert(pos.i, JSON(x)); }
 	inline iterator insert(iterator pos, const_reference x) { return v.insert(pos.i, x); }
+	inline iterator insert(iterator pos, value_type&& x) { return v.insert(pos.i, std::move(x)); }
 	inline void insert(iterator pos, size_type n, const_reference x) { v.insert(pos.i, n, x); }
+	template <class... Args>
+	inline iterator emplace(iterator pos, Args&&... args) { return v.emplace(pos.i, std::forward<Args>(args)...); }
 	template <class InputIterator>
 	inline iterator insert(iterator pos, InputIterator f, InputIterator l) { return v.insert(pos.i, f, l); }
 
@@ -269,17 +468,432 @@ public:
 	inline bool operator<(const JSONArray& x) const { return v<x.v; }
 };
 
+//
+// array of object members for JSONOrderedMap; the keys are const, so members
+// that move are made again in their new place from a copy of the key and the
+// moved value, and the keys are copied before anything changes
+//
+class json_members {
+public:
+	typedef std::pair<const std::string,JSON> value_type;
+	typedef JSONAllocator<value_type> allocator_type;
+private:
+	allocator_type a;
+	value_type *p;
+	size_t n, c;  // size, capacity
+
+	inline void grow(size_t size);
+	inline static void keys(const value_type *f, const value_type *l, std::string *out);
+public:
+	inline json_members() noexcept : p(0), n(0), c(0) { }
+	inline explicit json_members(const allocator_type& a) noexcept : a(a), p(0), n(0), c(0) { }
+	inline json_members(const json_members& x) : json_members(x.a.select_on_container_copy_construction()) { append(x); }
+	inline json_members(json_members&& x) noexcept : a(x.a), p(x.p), n(x.n), c(x.c) { x.p = 0; x.n = x.c = 0; }
+	inline ~json_members() { clear(); if (p) a.deallocate(p, c); }
+
+	inline json_members& operator=(const json_members& x) {
+		if (this!=&x) {
+			json_members y(a);
+			y.append(x);
+			std::swap(p, y.p);
+			std::swap(n, y.n);
+			std::swap(c, y.c);
+		}
+		return *this;
+	}
+	inline json_members& operator=(json_members&& x) noexcept { json_members y(std::move(x)); swap(y); return *this; }
+	inline void swap(json_members& x) noexcept { std::swap(a, x.a); std::swap(p, x.p); std::swap(n, x.n); std::swap(c, x.c); }
+	inline const allocator_type& get_allocator() const { return a; }
+
+	inline value_type *data() { return p; }
+	inline const value_type *data() const { return p; }
+	inline size_t size() const { return n; }
+	inline size_t capacity() const { return c; }
+	inline size_t max_size() const { return (size_t)-1 / sizeof(value_type); }
+	inline bool empty() const { return !n; }
+	inline value_type& operator[](size_t i) { return p[i]; }
+	inline const value_type& operator[](size_t i) const { return p[i]; }
+
+	inline void reserve(size_t size) { if (size > c) grow(size); }
+	inline void clear() { while (n) p[--n].~value_type(); }
+	inline void append(const json_members& x);
+	inline value_type& insert(size_t i, std::string&& k, JSON&& v);  // members from @i up move up one
+	inline void erase(size_t f, size_t l);  // members from @l on move down over [@f,@l)
+};
+
+
+//
+// hash map from std::string to JSON that keeps members in insertion order:
+// they are stored in an array, and found through an open-addressing index;
+// erase() only marks members, which keep their keys and index slots until
+// they are dropped when the array next fills up; insertion can move the
+// members, and so invalidates references and iterators as vector's does
+//
+class JSONOrderedMap {
+public:
+	typedef std::string key_type;
+	typedef JSON mapped_type;
+	typedef std::pair<const std::string,JSON> value_type;
+	typedef JSONAllocator<value_type> allocator_type;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+private:
+	template <typename M, typename V>
+	class iterator_t {
+		friend class JSONOrderedMap;
+		template <typename, typename> friend class iterator_t;
+
+		M *m;
+		size_t i;  // member index
+		iterator_t(M *m, size_t i) : m(m), i(i) { }
+	public:
+		typedef std::bidirectional_iterator_tag iterator_category;
+		typedef JSONOrderedMap::value_type value_type;
+		typedef ptrdiff_t difference_type;
+		typedef V *pointer;
+		typedef V& reference;
+
+		iterator_t() : m(0), i(0) { }
+		template <typename M2, typename V2>
+		iterator_t(const iterator_t<M2,V2>& x) : m(x.m), i(x.i) { }
+
+		reference operator*() const { return m->v[i]; }
+		pointer operator->() const { return &m->v[i]; }
+
+		bool operator==(const iterator_t& x) const { return i==x.i; }
+		bool operator!=(const iterator_t& x) const { return i!=x.i; }
+
+		iterator_t& operator++() { do ++i; while (i < m->v.size() && m->erased(i)); return *this; }
+		iterator_t operator++(int) { iterator_t x(*this); ++*this; return x; }
+		iterator_t& operator--() { do --i; while (m->erased(i)); return *this; }
+		iterator_t operator--(int) { iterator_t x(*this); --*this; return x; }
+	};
+public:
+	typedef iterator_t<JSONOrderedMap,value_type> iterator;
+	typedef iterator_t<const JSONOrderedMap,const value_type> const_iterator;
+	typedef std::reverse_iterator<iterator> reverse_iterator;
+	typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+private:
+	typedef std::pair<std::string,JSON> entry;  // value_type with a key that can be moved
+	struct Slot {
+		uint32_t i;  // member index + 1, or 0 if the slot is empty
+		uint32_t h;  // hash of the key
+	};
+
+	json_members v;
+	std::vector<Slot,JSONAllocator<Slot> > t;  // empty if v.size()<=SMALL, else a power of 2 that is at least twice v.size()
+	std::vector<bool,JSONAllocator<bool> > e;  // which members are erased; those past its end are not
+	size_t dead;  // members erased
+	size_t first;  // index of the first member that is not erased
+
+	inline bool erased(size_t i) const { return i < e.size() && e[i]; }
+	inline size_t index(const char *s, size_t n, size_t& slot) const;
+	inline void rehash(size_t size);
+	inline void compact();
+	inline std::pair<iterator,bool> add(entry&& x);
+	inline void sorted(std::vector<const value_type*>& out) const;
+	inline static bool less(const value_type *a, const value_type *b) { return *a < *b; }
+public:
+	enum { SMALL=8 };  // up to this many members are searched linearly, without an index
+
+	inline static uint32_t hash(const char *s, size_t n);
+
+	inline JSONOrderedMap() : dead(0), first(0) { }
+	inline explicit JSONOrderedMap(const allocator_type& a) : v(a), t(a), e(a), dead(0), first(0) { }
+	inline JSONOrderedMap(const JSONOrderedMap& x) : v(x.v), t(x.t), e(x.e), dead(x.dead), first(x.first) { }
+	inline JSONOrderedMap(JSONOrderedMap&& x) noexcept : v(std::move(x.v)), t(std::move(x.t)), e(std::move(x.e)), dead(x.dead), first(x.first) { x.dead = x.first = 0; }
+	template <class InputIterator>
+	inline JSONOrderedMap(InputIterator a, InputIterator b) : dead(0), first(0) { insert(a,b); }
+
+	inline JSONOrderedMap& operator=(const JSONOrderedMap& x) { v=x.v; t=x.t; e=x.e; dead=x.dead; first=x.first; return *this; }
+	inline JSONOrderedMap& operator=(JSONOrderedMap&& x) noexcept { JSONOrderedMap y(std::move(x)); swap(y); return *this; }
+
+	inline iterator begin() { return iterator(this, first); }
+	inline iterator end() { return iterator(this, v.size()); }
+	inline const_iterator begin() const { return const_iterator(this, first); }
+	inline const_iterator end() const { return const_iterator(this, v.size()); }
+	inline reverse_iterator rbegin() { return reverse_iterator(end()); }
+	inline reverse_iterator rend() { return reverse_iterator(begin()); }
+	inline const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+	inline const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+	inline size_type size() const { return v.size()-dead; }
+	inline size_type max_size() const { return v.max_size(); }
+	inline bool empty() const { return size()==0; }
+	inline void swap(JSONOrderedMap& x) { v.swap(x.v); t.swap(x.t); e.swap(x.e); std::swap(dead, x.dead); std::swap(first, x.first); }
+	inline void clear() { v.clear(); t.clear(); e.clear(); dead = first = 0; }
+
+	inline iterator find(const char *s, size_t n) {
+		size_t slot, i = index(s, n, slot);
+		return i==(size_t)-1 ? end() : iterator(this, i);
+	}
+	inline const_iterator find(const char *s, size_t n) const {
+		size_t slot, i = index(s, n, slot);
+		return i==(size_t)-1 ? end() : const_iterator(this, i);
+	}
+	inline iterator find(const key_type& k) { return find(k.data(), k.size()); }
+	inline const_iterator find(const key_type& k) const { return find(k.data(), k.size()); }
+	inline size_type count(const key_type& k) const { return find(k)!=end(); }
+
+	inline std::pair<iterator,bool> insert(const value_type& x) { return add(entry(x.first, x.second)); }
+	inline std::pair<iterator,bool> insert(value_type&& x) { return add(entry(x.first, std::move(x.second))); }  // the key is const
+	template <class P, class = typename std::enable_if<std::is_constructible<entry,P&&>::value>::type>
+	inline std::pair<iterator,bool> insert(P&& x) { return add(entry(std::forward<P>(x))); }  // such as a pair<string,JSON>, whose key is moved
+	inline iterator insert(iterator, const value_type& x) { return insert(x).first; }
+	template <class InputIterator>
+	inline void insert(InputIterator f, InputIterator l) { for (; f!=l ; ++f) insert(*f); }
+	template <class... Args>
+	inline std::pair<iterator,bool> emplace(Args&&... args) { return add(entry(std::forward<Args>(args)...)); }
+
+	inline JSON& operator[](const key_type& k) {
+		iterator i = find(k);
+		return i!=end() ? i->second : add(entry(k, JSON())).first->second;
+	}
+	inline JSON& operator[](key_type&& k) {
+		iterator i = find(k);
+		return i!=end() ? i->second : add(entry(std::move(k), JSON())).first->second;
+	}
+
+	inline void erase(iterator pos);
+	inline size_type erase(const key_type& k) {
+		iterator i = find(k);
+		if (i==end()) return 0;
+		erase(i);
+		return 1;
+	}
+	inline void erase(iterator f, iterator l) { while (f!=l) erase(f++); }
+
+	inline bool operator==(const JSONOrderedMap& x) const;  // regardless of order
+	inline bool operator<(const JSONOrderedMap& x) const;  // in key order, as for std::map
+};
+
+
+//
+// sorted map from std::string to JSON: up to SMALL members are kept in flat
+// slots and searched linearly, and beyond that they move to a std::map; the
+// slots come in two blocks of SMALL/2 that are allocated as they are needed
+// and never move, and an array of their numbers keeps them in key order, so
+// that references and iterators stay valid as with std::map, until the
+// member past SMALL moves all of them into the tree; iterators to flat
+// members refer to the map for that order, so unlike references they do not
+// follow the members through a swap() or a move of the map
+//
+class JSONSmallMap {
+public:
+	typedef std::string key_type;
+	typedef JSON mapped_type;
+	typedef std::pair<const std::string,JSON> value_type;
+	typedef JSONAllocator<value_type> allocator_type;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+
+	static const unsigned char SMALL = 8;
+private:
+	typedef std::pair<std::string,JSON> entry;  // value_type with a key that can be moved
+	typedef std::map<std::string,JSON,std::less<std::string>,allocator_type> tree_type;
+	enum { HALF=SMALL/2 };
+
+	template <typename M, typename V, typename I>
+	class iterator_t {
+		friend class JSONSmallMap;
+		template <typename, typename, typename> friend class iterator_t;
+
+		M *m;  // the map, if the members are in flat slots, or 0 if they are in the tree
+		unsigned char k;  // flat slot, or SMALL at the end
+		I i;  // tree position
+		iterator_t(M *m, unsigned char k) : m(m), k(k) { }
+		iterator_t(const I& x) : m(0), k(0), i(x) { }
+	public:
+		typedef std::bidirectional_iterator_tag iterator_category;
+		typedef JSONSmallMap::value_type value_type;
+		typedef ptrdiff_t difference_type;
+		typedef V *pointer;
+		typedef V& reference;
+
+		iterator_t() : m(0), k(0) { }
+		template <typename M2, typename V2, typename I2>
+		iterator_t(const iterator_t<M2,V2,I2>& x) : m(x.m), k(x.k), i(x.i) { }
+
+		reference operator*() const { return m ? m->slot(k) : *i; }
+		pointer operator->() const { return m ? &m->slot(k) : &*i; }
+
+		bool operator==(const iterator_t& x) const { return m ? k==x.k : !x.m && i==x.i; }
+		bool operator!=(const iterator_t& x) const { return !(*this==x); }
+
+		iterator_t& operator++() { if (m) k = m->after(k); else ++i; return *this; }
+		iterator_t operator++(int) { iterator_t x(*this); ++*this; return x; }
+		iterator_t& operator--() { if (m) k = m->before(k); else --i; return *this; }
+		iterator_t operator--(int) { iterator_t x(*this); --*this; return x; }
+	};
+public:
+	typedef iterator_t<JSONSmallMap,value_type,tree_type::iterator> iterator;
+	typedef iterator_t<const JSONSmallMap,const value_type,tree_type::const_iterator> const_iterator;
+	typedef std::reverse_iterator<iterator> reverse_iterator;
+	typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+private:
+	value_type *b[2];  // blocks of HALF flat slots, or 0 until one is needed
+	unsigned char o[SMALL];  // the flat slots in use, in key order
+	unsigned char n;  // flat members
+	unsigned used;  // a bit for each flat slot in use
+	allocator_type a;
+	tree_type m;
+	bool tree;  // members are in @m, none are flat
+
+	inline value_type& slot(unsigned k) { return b[k/HALF][k%HALF]; }
+	inline const value_type& slot(unsigned k) const { return b[k/HALF][k%HALF]; }
+	inline size_t order(unsigned k) const { size_t j = 0; while (o[j]!=k) ++j; return j; }  // of a slot in use
+	inline unsigned char after(unsigned k) const { size_t j = order(k)+1; return j<n ? o[j] : SMALL; }
+	inline unsigned char before(unsigned k) const { return k==SMALL ? o[n-1] : o[order(k)-1]; }
+	inline size_t position(const key_type& k) const;
+	template <class... Args>
+	inline unsigned char place(size_t j, Args&&... args);
+	inline void remove(unsigned k);
+	inline void assign(const JSONSmallMap& x);
+	inline void promote();
+	inline std::pair<iterator,bool> add(entry&& x);
+public:
+	inline JSONSmallMap() : n(0), used(0), tree(false) { b[0] = b[1] = 0; }
+	inline explicit JSONSmallMap(const allocator_type& a) : n(0), used(0), a(a), m(std::less<std::string>(), a), tree(false) { b[0] = b[1] = 0; }
+	inline JSONSmallMap(const JSONSmallMap& x) : JSONSmallMap(x.a.select_on_container_copy_construction()) { assign(x); }
+	inline JSONSmallMap(JSONSmallMap&& x) noexcept : n(x.n), used(x.used), a(x.a), m(std::move(x.m)), tree(x.tree) {
+		memcpy(b, x.b, sizeof(b));
+		memcpy(o, x.o, sizeof(o));
+		x.b[0] = x.b[1] = 0;
+		x.n = 0;
+		x.used = 0;
+		x.tree = false;
+	}
+	template <class InputIterator>
+	inline JSONSmallMap(InputIterator f, InputIterator l) : JSONSmallMap() { insert(f,l); }
+	inline ~JSONSmallMap() {
+		clear();
+		for (int j = 0 ; j < 2 ; ++j)
+			if (b[j]) a.deallocate(b[j], HALF);
+	}
+
+	inline JSONSmallMap& operator=(const JSONSmallMap& x) {
+		if (this!=&x) {
+			JSONSmallMap y(a);
+			y.assign(x);
+			swap(y);
+		}
+		return *this;
+	}
+	inline JSONSmallMap& operator=(JSONSmallMap&& x) noexcept { JSONSmallMap y(std::move(x)); swap(y); return *this; }
+
+	inline iterator begin() { return tree ? iterator(m.begin()) : iterator(this, n ? o[0] : SMALL); }
+	inline iterator end() { return tree ? iterator(m.end()) : iterator(this, SMALL); }
+	inline const_iterator begin() const { return tree ? const_iterator(m.begin()) : const_iterator(this, n ? o[0] : SMALL); }
+	inline const_iterator end() const { return tree ? const_iterator(m.end()) : const_iterator(this, SMALL); }
+	inline reverse_iterator rbegin() { return reverse_iterator(end()); }
+	inline reverse_iterator rend() { return reverse_iterator(begin()); }
+	inline const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+	inline const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+	inline size_type size() const { return tree ? m.size() : n; }
+	inline size_type max_size() const { return m.max_size(); }
+	inline bool empty() const { return size()==0; }
+	inline void swap(JSONSmallMap& x) {
+		std::swap(b, x.b);
+		std::swap(o, x.o);
+		std::swap(n, x.n);
+		std::swap(used, x.used);
+		std::swap(a, x.a);
+		m.swap(x.m);
+		std::swap(tree, x.tree);
+	}
+	inline void clear() {  // the flat blocks are kept
+		for (size_t j = 0 ; j < n ; ++j)
+			slot(o[j]).~value_type();
+		n = 0;
+		used = 0;
+		m.clear();
+		tree = false;
+	}
+
+	inline iterator find(const key_type& k) {
+		if (tree) return m.find(k);
+		size_t j = position(k);
+		return j<n && slot(o[j]).first==k ? iterator(this, o[j]) : end();
+	}
+	inline const_iterator find(const key_type& k) const {
+		if (tree) return m.find(k);
+		size_t j = position(k);
+		return j<n && slot(o[j]).first==k ? const_iterator(this, o[j]) : end();
+	}
+	inline size_type count(const key_type& k) const { return find(k)!=end(); }
+
+	inline iterator lower_bound(const key_type& k) {
+		if (tree) return m.lower_bound(k);
+		size_t j = position(k);
+		return iterator(this, j<n ? o[j] : SMALL);
+	}
+	inline const_iterator lower_bound(const key_type& k) const {
+		if (tree) return m.lower_bound(k);
+		size_t j = position(k);
+		return const_iterator(this, j<n ? o[j] : SMALL);
+	}
+	inline iterator upper_bound(const key_type& k) { iterator i = lower_bound(k); return i!=end() && i->first==k ? ++i : i; }
+	inline const_iterator upper_bound(const key_type& k) const { const_iterator i = lower_bound(k); return i!=end() && i->first==k ? ++i : i; }
+	inline std::pair<iterator,iterator> equal_range(const key_type& k) { return std::pair<iterator,iterator>(lower_bound(k), upper_bound(k)); }
+	inline std::pair<const_iterator,const_iterator> equal_range(const key_type& k) const { return std::pair<const_iterator,const_iterator>(lower_bound(k), upper_bound(k)); }
+
+	inline std::pair<iterator,bool> insert(const value_type& x) { return add(entry(x.first, x.second)); }
+	inline std::pair<iterator,bool> insert(value_type&& x) { return add(entry(x.first, std::move(x.second))); }  // the key is const
+	template <class P, class = typename std::enable_if<std::is_constructible<entry,P&&>::value>::type>
+	inline std::pair<iterator,bool> insert(P&& x) { return add(entry(std::forward<P>(x))); }  // such as a pair<string,JSON>, whose key is moved
+	inline iterator insert(iterator, const value_type& x) { return insert(x).first; }
+	template <class InputIterator>
+	inline void insert(InputIterator f, InputIterator l) { for (; f!=l ; ++f) insert(*f); }
+	template <class... Args>
+	inline std::pair<iterator,bool> emplace(Args&&... args) { return add(entry(std::forward<Args>(args)...)); }
+
+	inline JSON& operator[](const key_type& k) {
+		iterator i = find(k);
+		return i!=end() ? i->second : add(entry(k, JSON())).first->second;
+	}
+	inline JSON& operator[](key_type&& k) {
+		iterator i = find(k);
+		return i!=end() ? i->second : add(entry(std::move(k), JSON())).first->second;
+	}
+
+	inline void erase(iterator pos) {
+		if (tree) m.erase(pos.i);
+		else remove(pos.k);
+	}
+	inline size_type erase(const key_type& k) {
+		iterator i = find(k);
+		if (i==end()) return 0;
+		erase(i);
+		return 1;
+	}
+	inline void erase(iterator f, iterator l) {
+		if (tree) m.erase(f.i, l.i);
+		else while (f!=l) remove((f++).k);
+	}
+
+	inline bool operator==(const JSONSmallMap& x) const { return size()==x.size() && std::equal(begin(), end(), x.begin()); }
+	inline bool operator<(const JSONSmallMap& x) const { return std::lexicographical_compare(begin(), end(), x.begin(), x.end()); }
+};
+
+
 class JSONObject : public JSONBase {
-	std::map<std::string,JSON> v;
+#ifdef STAJSON_ORDERED_OBJECTS
+	typedef JSONOrderedMap map_type;
+#else
+	typedef JSONSmallMap map_type;
+#endif
+	map_type v;
 public:
+	typedef JSONAllocator<std::pair<const std::string,JSON> > allocator_type;
 	typedef std::string key_type;
 	typedef JSON data_type;
 	typedef std::pair<const key_type,data_type> value_type;
 	typedef value_type *pointer;
 	typedef value_type& reference;
 	typedef const value_type& const_reference;
-	typedef std::map<std::string,JSON>::size_type size_type;
-	typedef std::map<std::string,JSON>::difference_type difference_type;
+	typedef map_type::size_type size_type;
+	typedef map_type::difference_type difference_type;
 private:
 	template <typename ITER, typename ELEM>
 	class iterator_t {
@@ -307,17 +921,20 @@ private:
 		void swap(iterator& x) { swap(i,x.i); }
 	};
 public:
-	typedef iterator_t<std::map<std::string,JSON>::iterator,value_type> iterator;
-	typedef iterator_t<std::map<std::string,JSON>::reverse_iterator,value_type> reverse_iterator;
-	typedef iterator_t<std::map<std::string,JSON>::const_iterator,const value_type> const_iterator;
-	typedef iterator_t<std::map<std::string,JSON>::const_reverse_iterator,const value_type> const_reverse_iterator;
+	typedef iterator_t<map_type::iterator,value_type> iterator;
+	typedef iterator_t<map_type::reverse_iterator,value_type> reverse_iterator;
+	typedef iterator_t<map_type::const_iterator,const value_type> const_iterator;
+	typedef iterator_t<map_type::const_reverse_iterator,const value_type> const_reverse_iterator;
 
 	inline JSONObject() : JSONBase(JSON_OBJECT) { }
+	inline explicit JSONObject(const allocator_type& a) : JSONBase(JSON_OBJECT), v(a) { }
 	inline JSONObject(const JSONObject& x) : JSONBase(JSON_OBJECT), v(x.v) { }
+	inline JSONObject(JSONObject&& x) noexcept : JSONBase(JSON_OBJECT), v(std::move(x.v)) { }
 	template <class InputIterator>
 	inline JSONObject(InputIterator a, InputIterator b) : JSONBase(JSON_OBJECT), v(a,b) { } 
 
 	inline JSONObject& operator=(const JSONObject& x) { v=x.v; return *this; }
+	inline JSONObject& operator=(JSONObject&& x) noexcept { v=std::move(x.v); return *this; }
 	inline void swap(JSONObject& x) { v.swap(x.v); }
 
 	inline iterator begin() { return v.begin(); }
@@ -334,12 +951,26 @@ public:
 	inline bool empty() const { return v.empty(); }
 
 	inline std::pair<iterator,bool> insert(const_reference x) {
-		std::pair<std::map<std::string,JSON>::iterator,bool> p = v.insert(x);
+		std::pair<map_type::iterator,bool> p = v.insert(x);
+		return std::pair<iterator,bool>(p.first,p.second);
+	}
+	inline std::pair<iterator,bool> insert(value_type&& x) {
+		std::pair<map_type::iterator,bool> p = v.insert(std::move(x));
+		return std::pair<iterator,bool>(p.first,p.second);
+	}
+	template <class P, class = typename std::enable_if<std::is_constructible<value_type,P&&>::value>::type>
+	inline std::pair<iterator,bool> insert(P&& x) {
+		std::pair<map_type::iterator,bool> p = v.insert(std::forward<P>(x));
 		return std::pair<iterator,bool>(p.first,p.second);
 	}
 	inline iterator insert(iterator pos, const_reference x) { return v.insert(pos.i, x); }
 	template <class InputIterator>
 	inline void insert(InputIterator f, InputIterator l) { v.insert(f, l); }
+	template <class... Args>
+	inline std::pair<iterator,bool> emplace(Args&&... args) {
+		std::pair<map_type::iterator,bool> p = v.emplace(std::forward<Args>(args)...);
+		return std::pair<iterator,bool>(p.first,p.second);
+	}
 
 	inline void erase(iterator pos) { v.erase(pos.i); }
 	inline size_type erase(const key_type& k) { return v.erase(k); }
@@ -351,23 +982,60 @@ public:
 	inline size_type count(const key_type& k) const { return v.count(k); }
 	inline bool has(const key_type& s) const { return v.find(s)!=v.end(); }
 
+#ifndef STAJSON_ORDERED_OBJECTS
 	inline iterator lower_bound(const key_type& k) { return v.lower_bound(k); }
 	inline const_iterator lower_bound(const key_type& k) const { return v.lower_bound(k); }
 	inline iterator upper_bound(const key_type& k) { return v.upper_bound(k); }
 	inline const_iterator upper_bound(const key_type& k) const { return v.upper_bound(k); }
-	inline std::pair<iterator,iterator> equal_range(const key_type& k) { return equal_range(k); }
-	inline std::pair<const_iterator,const_iterator> equal_range(const key_type& k) const { return equal_range(k); }
+	inline std::pair<iterator,iterator> equal_range(const key_type& k) {
+		std::pair<map_type::iterator,map_type::iterator> p = v.equal_range(k);
+		return std::pair<iterator,iterator>(p.first,p.second);
+	}
+	inline std::pair<const_iterator,const_iterator> equal_range(const key_type& k) const {
+		std::pair<map_type::const_iterator,map_type::const_iterator> p = v.equal_range(k);
+		return std::pair<const_iterator,const_iterator>(p.first,p.second);
+	}
+#endif
 
 	inline JSON& get(const key_type& s);
 	inline const JSON& get(const key_type& s) const;
 
 	inline data_type& operator[](const key_type& k) { return v[k]; }
+	inline data_type& operator[](key_type&& k) { return v[std::move(k)]; }
 
 	inline bool operator==(const JSONObject& x) const { return v==x.v; }
 	inline bool operator<(const JSONObject& x) const { return v<x.v; }
 };
 
 
+//
+// a decoded tree that lives in its own JSONArena, and is freed all at once;
+// read it through root(), copies of its values are ordinary heap values
+//
+class JSONDocument {
+	friend void json_decode(const std::string& in, JSONDocument& out);
+	friend void json_decode(std::istream& in, JSONDocument& out);
+	friend void json_decode_borrowed(const std::string& in, JSONDocument& out);
+	friend void json_decode(const char *s, size_t n, JSONDocument& out);
+	friend void json_decode_borrowed(const char *s, size_t n, JSONDocument& out);
+	friend void json_decode_file(const char *path, JSONDocument& out);
+
+	JSONArena a;
+	JSON r;
+
+	JSONDocument(const JSONDocument&);
+	JSONDocument& operator=(const JSONDocument&);
+public:
+	inline JSONDocument() { }
+
+	inline const JSON& root() const { return r; }
+	inline operator const JSON&() const { return r; }
+	inline JSONType type() const { return r.type(); }
+
+	inline void clear() { r.set(0); a.release(); }
+};
+
+
 class json_type_error : public std::runtime_error {
 public:
 	json_type_error(const std::string& s) : std::runtime_error(s) { }
@@ -407,11 +1075,72 @@ inline std::string json_encode(const JSONObject& in) { std::string out; json_enc
 void json_encode(const JSONObject& in, std::ostream& out);
 inline std::ostream& operator<<(std::ostream& out, const JSONObject& in) { json_encode(in,out); return out; }
 
+// arrays and objects nested deeper than this are rejected by json_decode(),
+// before the recursive destructor and encoder could run out of stack on them;
+// 0 for no limit
+extern size_t json_max_depth;
+
 void json_decode(const std::string& in, JSON& out);
 inline JSON json_decode(const std::string& in) { JSON out; json_decode(in,out); return out; }
 void json_decode(std::istream& in, JSON& out);
 inline std::istream& operator>>(std::istream& in, JSON& out) { json_decode(in,out); return in; }
 
+void json_decode(const std::string& in, JSONDocument& out);
+void json_decode(std::istream& in, JSONDocument& out);
+// strings without escapes are not copied, but refer to the characters of @in,
+// which must not change or go away until @out is cleared
+void json_decode_borrowed(const std::string& in, JSONDocument& out);
+
+// the same from the @n characters at @s, which need not end in a NUL
+void json_decode(const char *s, size_t n, JSON& out);
+void json_decode(const char *s, size_t n, JSONDocument& out);
+void json_decode_borrowed(const char *s, size_t n, JSONDocument& out);
+inline void json_decode(const char *in, JSON& out) { json_decode(in,strlen(in),out); }
+inline JSON json_decode(const char *in) { JSON out; json_decode(in,out); return out; }
+inline void json_decode(const char *in, JSONDocument& out) { json_decode(in,strlen(in),out); }
+inline void json_decode_borrowed(const char *in, JSONDocument& out) { json_decode_borrowed(in,strlen(in),out); }
+// decodes the value at the start of @s, which may be followed by anything,
+// such as more values, and returns the number of characters up to its end
+size_t json_decode_prefix(const char *s, size_t n, JSON& out);
+
+#if __cplusplus >= 201703L
+inline void json_decode(std::string_view in, JSON& out) { json_decode(in.data(),in.size(),out); }
+inline JSON json_decode(std::string_view in) { JSON out; json_decode(in,out); return out; }
+inline void json_decode(std::string_view in, JSONDocument& out) { json_decode(in.data(),in.size(),out); }
+inline void json_decode_borrowed(std::string_view in, JSONDocument& out) { json_decode_borrowed(in.data(),in.size(),out); }
+inline size_t json_decode_prefix(std::string_view in, JSON& out) { return json_decode_prefix(in.data(),in.size(),out); }
+#endif
+
+// the file at @path is mapped into memory and decoded from there, instead
+// of being read into a string first; into a JSONDocument, the file stays
+// mapped until the document is cleared, and strings without escapes refer
+// to it, as with json_decode_borrowed()
+void json_decode_file(const char *path, JSON& out);
+void json_decode_file(const char *path, JSONDocument& out);
+
+// json_extract() decodes only the value at a JSON Pointer (RFC 6901), such
+// as "/user/id", and returns false if there is none; the values off its way
+// are skipped by their quotes and brackets, without being checked or decoded,
+// and of repeated keys the last one is taken, as by json_decode()
+bool json_extract(const char *s, size_t n, const std::string& pointer, JSON& out);
+inline bool json_extract(const std::string& in, const std::string& pointer, JSON& out) { return json_extract(in.data(),in.size(),pointer,out); }
+JSON json_extract(const std::string& in, const std::string& pointer);  // throws std::out_of_range if there is none
+// the values at several pointers in one pass: @out gets one per pointer, null
+// where there is none, and the number found is returned
+size_t json_extract(const char *s, size_t n, const std::vector<std::string>& pointers, std::vector<JSON>& out);
+inline size_t json_extract(const std::string& in, const std::vector<std::string>& pointers, std::vector<JSON>& out) { return json_extract(in.data(),in.size(),pointers,out); }
+
+// json_parse() decodes a value without building a tree: @h is called for
+// each part of it, in order, as
+//	h.null(), h.boolean(bool), h.number(const JSONNumber&),
+//	h.string(const char *s, size_t n), h.key(const char *s, size_t n),
+//	h.start_object(), h.end_object(), h.start_array(), h.end_array()
+// with the characters of strings and keys only valid during the call; errors
+// are thrown as by json_decode(), after the calls for what came before them
+template <class Handler> void json_parse(const char *s, size_t n, Handler& h);
+template <class Handler> void json_parse(const std::string& in, Handler& h) { json_parse(in.data(),in.size(),h); }
+template <class Handler> void json_parse(std::istream& in, Handler& h);
+
 inline static std::string json_fmt(const char *fmt, ...);
 
 
@@ -419,7 +1148,7 @@ inline static std::string json_fmt(const char *fmt, ...);
 // JSONBase
 //
 inline static void JSONBase::operator delete(void *p) {
-	if (p) switch ( ((JSONBase*)p)->t ) {
+	if (p && !(((JSONBase*)p)->f & ARENA)) switch ( ((JSONBase*)p)->t ) {
 	case JSON_NULL: break;
 	case JSON_BOOLEAN: ::delete ((JSONBool*)p); break;
 	case JSON_NUMBER: ::delete ((JSONNumber*)p); break;
@@ -428,138 +1157,337 @@ inline static void JSONBase::operator delete(void *p) {
 	case JSON_OBJECT: ::delete ((JSONObject*)p); break;
 	}
 }
+template <class T, class... Args>
+inline T *JSONBase::make(Args&&... args) {  // a throwing constructor must not reach our operator delete
+	void *p = ::operator new(sizeof(T));
+	try {
+		return new (p) T(std::forward<Args>(args)...);
+	} catch (...) {
+		::operator delete(p);
+		throw;
+	}
+}
+inline void JSONBase::destroy(JSONBase *p) {  // the way make() allocates, so that the pairs match
+	if (p->f & ARENA) return;
+	switch (p->t) {
+	case JSON_NULL: p->~JSONBase(); break;
+	case JSON_BOOLEAN: ((JSONBool*)p)->~JSONBool(); break;
+	case JSON_NUMBER: ((JSONNumber*)p)->~JSONNumber(); break;
+	case JSON_STRING: ((JSONString*)p)->~JSONString(); break;
+	case JSON_ARRAY: ((JSONArray*)p)->~JSONArray(); break;
+	case JSON_OBJECT: ((JSONObject*)p)->~JSONObject(); break;
+	}
+	::operator delete(p);
+}
 inline JSONBase *JSONBase::copy() {
 	switch (t) {
 	case JSON_NULL:
 		return 0;
 	case JSON_BOOLEAN:
-		return new JSONBool(*(JSONBool*)this);
+		return make<JSONBool>(*(JSONBool*)this);
 	case JSON_NUMBER:
-		return new JSONNumber(*(JSONNumber*)this);
+		return make<JSONNumber>(*(JSONNumber*)this);
 	case JSON_STRING:
-		return new JSONString(*(JSONString*)this);
+		return make<JSONString>(*(JSONString*)this);
 	case JSON_ARRAY:
-		return new JSONArray(*(JSONArray*)this);
+		return make<JSONArray>(*(JSONArray*)this);
 	case JSON_OBJECT:
-		return new JSONObject(*(JSONObject*)this);
+		return make<JSONObject>(*(JSONObject*)this);
 	default:
 		throw std::logic_error("corrupt JSON object");
 	}
 }
 
 
+//
+// JSONArena
+//
+inline void *JSONArena::allocate(size_t n, size_t align) {
+	char *p = (char*)(((size_t)pos + align-1) & ~(align-1));
+	if (!pos || p+n > end) return grow(n, align);
+	pos = p+n;
+	return p;
+}
+template <class T, class... Args>
+inline T *JSONArena::make(Args&&... args) {
+	T *p = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+	p->f |= JSONBase::ARENA;
+	return p;
+}
+template <class T>
+static void json_arena_destroy(void *p) {
+	((T*)p)->~T();
+}
+template <class T>
+inline void JSONArena::own(T *p) {
+	Cleanup *c = (Cleanup*)allocate(sizeof(Cleanup), alignof(Cleanup));
+	c->f = json_arena_destroy<T>;
+	c->p = p;
+	c->next = cleanups;
+	cleanups = c;
+}
+
+
 //
 // JSON
 //
-inline JSON::JSON() : p(0) {
+inline JSON::JSON() {
+	new (d) Ref();
+}
+inline JSON::JSON(bool v) {
+	new (d) JSONBool(v);
+}
+inline JSON::JSON(double v) {
+	new (d) JSONNumber(v);
 }
-inline JSON::JSON(bool v) : p(new JSONBool(v)) {
+inline JSON::JSON(int v) {
+	new (d) JSONNumber((int64_t)v);
 }
-inline JSON::JSON(double v) : p(new JSONNumber(v)) {
+inline JSON::JSON(int64_t v) {
+	new (d) JSONNumber(v);
 }
-inline JSON::JSON(const char *v) : p(new JSONString(v)) {
+inline JSON::JSON(const char *v) {
+	new (d) Ref(JSONBase::make<JSONString>(v));
 }
-inline JSON::JSON(const std::string& v) : p(new JSONString(v)) {
+inline JSON::JSON(const std::string& v) {
+	new (d) Ref(JSONBase::make<JSONString>(v));
 }
-inline JSON::JSON(const JSONArray& v) : p(new JSONArray(v)) {
+inline JSON::JSON(const JSONArray& v) {
+	new (d) Ref(JSONBase::make<JSONArray>(v));
 }
-inline JSON::JSON(const JSONObject& v) : p(new JSONObject(v)) {
+inline JSON::JSON(const JSONObject& v) {
+	new (d) Ref(JSONBase::make<JSONObject>(v));
 }
-inline JSON::JSON(const JSON& x) : p(x.p ? x.p->copy() : 0) {
+inline JSON::JSON(const JSON& x) {
+	new (d) Ref();
+	assign(x);
+}
+inline JSON::JSON(std::string&& v) {
+	new (d) Ref(JSONBase::make<JSONString>(std::move(v)));
+}
+inline JSON::JSON(JSONArray&& v) {
+	new (d) Ref(JSONBase::make<JSONArray>(std::move(v)));
+}
+inline JSON::JSON(JSONObject&& v) {
+	new (d) Ref(JSONBase::make<JSONObject>(std::move(v)));
+}
+inline JSON::JSON(JSON&& x) noexcept {
+	new (d) Ref();
+	take(x);
 }
 inline JSON::~JSON() {
-	if (p) delete p;
+	if (boxed()) release(node());
 }
 inline JSON& JSON::operator=(bool v) {
-	if (p) delete p;
-	p = new JSONBool(v);
+	clear();
+	new (d) JSONBool(v);
 	return *this;
 }
 inline JSON& JSON::operator=(double v) {
-	if (p) delete p;
-	p = new JSONNumber(v);
+	clear();
+	new (d) JSONNumber(v);
+	return *this;
+}
+inline JSON& JSON::operator=(int v) {
+	return *this = (int64_t)v;
+}
+inline JSON& JSON::operator=(int64_t v) {
+	clear();
+	new (d) JSONNumber(v);
 	return *this;
 }
 inline JSON& JSON::operator=(const char *v) {
-	if (p) delete p;
-	p = new JSONString(v);
+	box(JSONBase::make<JSONString>(v));
 	return *this;
 }
 inline JSON& JSON::operator=(const std::string& v) {
-	if (p) delete p;
-	p = new JSONString(v);
+	box(JSONBase::make<JSONString>(v));
 	return *this;
 }
 inline JSON& JSON::operator=(const JSONArray& v) {
-	if (p) delete p;
-	p = new JSONArray(v);
+	box(JSONBase::make<JSONArray>(v));
 	return *this;
 }
 inline JSON& JSON::operator=(const JSONObject& v) {
-	if (p) delete p;
-	p = new JSONObject(v);
+	box(JSONBase::make<JSONObject>(v));
 	return *this;
 }
 inline JSON& JSON::operator=(const JSON& x) {
-	if (p) delete p;
-	p = x.p ? x.p->copy() : 0;
+	switch (x.type()) {  // @x may be a member of this value, so it is copied first
+	case JSON_NULL:
+		clear();
+		break;
+	case JSON_BOOLEAN:
+		*this = x.as<JSONBool>().value();
+		break;
+	case JSON_NUMBER: {
+		JSONNumber n(x.as<JSONNumber>());
+		clear();
+		new (d) JSONNumber(n);
+		} break;
+	default:
+		if (this!=&x) box(hold(x.node()));
+	}
+	return *this;
+}
+inline JSON& JSON::operator=(std::string&& v) {
+	box(JSONBase::make<JSONString>(std::move(v)));
+	return *this;
+}
+inline JSON& JSON::operator=(JSONArray&& v) {
+	box(JSONBase::make<JSONArray>(std::move(v)));
+	return *this;
+}
+inline JSON& JSON::operator=(JSONObject&& v) {
+	box(JSONBase::make<JSONObject>(std::move(v)));
+	return *this;
+}
+inline JSON& JSON::operator=(JSON&& x) noexcept {
+	if (!x.boxed()) return *this = x;
+	if (this!=&x) {
+		JSONBase *p = x.node();  // @x may be a member of this value
+		new (x.d) Ref();
+		box(p);
+	}
 	return *this;
 }
 
-inline JSONBase *JSON::get() {
+inline bool JSON::boxed() const {
+	return as<JSONBase>().type()>=JSON_STRING;
+}
+inline void JSON::release(JSONBase *p) {
+	// whoever takes the count below zero had the last reference, even if
+	// another copy let go of the node at the same time
+	if (p->refs.load(std::memory_order_acquire)==0 || p->refs.fetch_sub(1, std::memory_order_acq_rel)==0)
+		JSONBase::destroy(p);
+}
+inline void JSON::unshare() {
+	// the first modification of a shared node copies it; as a reference into
+	// the node is then handed out, it is no longer shared by later copies,
+	// which could not see what is done through that reference
+	if (!boxed()) return;
+	if (node()->refs.load(std::memory_order_acquire)) {
+		JSONBase *p = node();
+		as<Ref>().p = p->copy();
+		release(p);
+	}
+	node()->f &= ~JSONBase::SHARED;
+}
+inline JSONBase *JSON::hold(JSONBase *p) {  // for a copy: @p itself if shared, or a copy of it
+	if (!(p->f & JSONBase::SHARED)) return p->copy();
+	p->refs.fetch_add(1, std::memory_order_relaxed);
 	return p;
 }
+inline void JSON::clear() {
+	if (boxed()) release(node());
+	new (d) Ref();
+}
+inline void JSON::box(JSONBase *pp) {  // takes ownership of a string, array or object node
+	clear();
+	new (d) Ref(pp);
+}
+inline void JSON::assign(const JSON& x) {  // this value must be null
+	switch (x.type()) {
+	case JSON_NULL: break;
+	case JSON_BOOLEAN: new (d) JSONBool(x.as<JSONBool>()); break;
+	case JSON_NUMBER: new (d) JSONNumber(x.as<JSONNumber>()); break;
+	default: new (d) Ref(hold(x.node())); break;
+	}
+}
+inline void JSON::take(JSON& x) {  // this value must be null; @x becomes null
+	switch (x.type()) {
+	case JSON_NULL: break;
+	case JSON_BOOLEAN: new (d) JSONBool(x.as<JSONBool>()); break;
+	case JSON_NUMBER: new (d) JSONNumber(x.as<JSONNumber>()); break;
+	default: new (d) Ref(x.node()); break;
+	}
+	new (x.d) Ref();
+}
+
+inline JSONBase *JSON::get() {
+	unshare();
+	switch (type()) {
+	case JSON_NULL: return 0;
+	case JSON_BOOLEAN: return &as<JSONBool>();
+	case JSON_NUMBER: return &as<JSONNumber>();
+	default: return node();
+	}
+}
 inline const JSONBase *JSON::get() const {
-	return p;
+	switch (type()) {
+	case JSON_NULL: return 0;
+	case JSON_BOOLEAN: return &as<JSONBool>();
+	case JSON_NUMBER: return &as<JSONNumber>();
+	default: return node();
+	}
 }
 inline void JSON::set(JSONBase *pp) {  // takes ownership
-	if (p) delete p;
-	p = pp;
+	if (pp==0) {
+		clear();
+		return;
+	}
+	switch (pp->type()) {
+	case JSON_BOOLEAN:
+		*this = ((JSONBool*)pp)->value();
+		JSONBase::destroy(pp);
+		break;
+	case JSON_NUMBER:
+		clear();
+		new (d) JSONNumber(*(JSONNumber*)pp);
+		JSONBase::destroy(pp);
+		break;
+	default:
+		clear();
+		new (d) Ref(pp);
+	}
 }
 
 inline JSONType JSON::type() const {
-	return p ? p->type() : JSON_NULL;
+	return as<JSONBase>().type();
 }
 
 inline JSONBool& JSON::boolean() {
 	if (type()!=JSON_BOOLEAN) throw json_type_error("not a JSON boolean");
-	return *(JSONBool*)p;
+	return as<JSONBool>();
 }
 inline const JSONBool& JSON::boolean() const {
 	if (type()!=JSON_BOOLEAN) throw json_type_error("not a JSON boolean");
-	return *(JSONBool*)p;
+	return as<JSONBool>();
 }
 inline JSONNumber& JSON::number() {
 	if (type()!=JSON_NUMBER) throw json_type_error("not a JSON number");
-	return *(JSONNumber*)p;
+	return as<JSONNumber>();
 }
 inline const JSONNumber& JSON::number() const {
 	if (type()!=JSON_NUMBER) throw json_type_error("not a JSON number");
-	return *(JSONNumber*)p;
+	return as<JSONNumber>();
 }
 inline JSONString& JSON::string() {
 	if (type()!=JSON_STRING) throw json_type_error("not a JSON string");
-	return *(JSONString*)p;
+	unshare();
+	return *(JSONString*)node();
 }
 inline const JSONString& JSON::string() const {
 	if (type()!=JSON_STRING) throw json_type_error("not a JSON string");
-	return *(JSONString*)p;
+	return *(JSONString*)node();
 }
 inline JSONArray& JSON::array() {
 	if (type()!=JSON_ARRAY) throw json_type_error("not a JSON array");
-	return *(JSONArray*)p;
+	unshare();
+	return *(JSONArray*)node();
 }
 inline const JSONArray& JSON::array() const {
 	if (type()!=JSON_ARRAY) throw json_type_error("not a JSON array");
-	return *(JSONArray*)p;
+	return *(JSONArray*)node();
 }
 inline const JSONObject& JSON::object() const {
 	if (type()!=JSON_OBJECT) throw json_type_error("not a JSON object");
-	return *(JSONObject*)p;
+	return *(JSONObject*)node();
 }
 inline JSONObject& JSON::object() {
 	if (type()!=JSON_OBJECT) throw json_type_error("not a JSON object");
-	return *(JSONObject*)p;
+	unshare();
+	return *(JSONObject*)node();
 }
 
 inline JSON& JSON::operator[](int i) {
@@ -574,16 +1502,28 @@ inline JSON& JSON::operator[](const char *s) {
 inline JSON& JSON::operator[](const std::string& s) {
 	return object()[s];
 }
-inline bool JSON::has(int i) {
+inline const JSON& JSON::operator[](int i) const {
+	return array()[i];
+}
+inline const JSON& JSON::operator[](size_t i) const {
+	return array()[i];
+}
+inline const JSON& JSON::operator[](const char *s) const {
+	return get(s);
+}
+inline const JSON& JSON::operator[](const std::string& s) const {
+	return get(s);
+}
+inline bool JSON::has(int i) const {
 	return i>=0 && array().size()>(size_t)i;
 }
-inline bool JSON::has(size_t i) {
+inline bool JSON::has(size_t i) const {
 	return array().size()>i;
 }
-inline bool JSON::has(const char *s) {
+inline bool JSON::has(const char *s) const {
 	return object().has(s);
 }
-inline bool JSON::has(const std::string& s) {
+inline bool JSON::has(const std::string& s) const {
 	return object().has(s);
 }
 inline JSON& JSON::get(int i) {
@@ -650,9 +1590,9 @@ inline static double json_strtod(const char *str) {
 inline JSON::operator bool() const {
 	switch (type()) {
 	case JSON_NULL: return false;
-	case JSON_BOOLEAN: return ((JSONBool*)p)->value();
-	case JSON_NUMBER: return ((JSONNumber*)p)->value() != 0.0;
-	case JSON_STRING: return ((JSONString*)p)->value().length() != 0;
+	case JSON_BOOLEAN: return as<JSONBool>().value();
+	case JSON_NUMBER: return as<JSONNumber>().value() != 0.0;
+	case JSON_STRING: return ((JSONString*)node())->size() != 0;
 	case JSON_ARRAY: throw json_type_error("JSON array cannot be converted to type bool");
 	case JSON_OBJECT: default: throw json_type_error("JSON object cannot be converted to type bool");
 	}
@@ -660,9 +1600,9 @@ inline JSON::operator bool() const {
 inline JSON::operator double() const {
 	switch (type()) {
 	case JSON_NULL: return 0.0;
-	case JSON_BOOLEAN: return ((JSONBool*)p)->value() ? 1.0 : 0.0;
-	case JSON_NUMBER: return ((JSONNumber*)p)->value();
-	case JSON_STRING: return json_strtod( ((JSONString*)p)->value().c_str() );
+	case JSON_BOOLEAN: return as<JSONBool>().value() ? 1.0 : 0.0;
+	case JSON_NUMBER: return as<JSONNumber>().value();
+	case JSON_STRING: return json_strtod( ((JSONString*)node())->value().c_str() );
 	case JSON_ARRAY: throw json_type_error("JSON array cannot be converted to type double");
 	case JSON_OBJECT: default: throw json_type_error("JSON object cannot be converted to type double");
 	}
@@ -671,14 +1611,260 @@ inline JSON::operator std::string() const {
 	switch (type()) {
 	case JSON_NULL: throw json_type_error("JSON NULL cannot be converted to type string");
 	case JSON_BOOLEAN: throw json_type_error("JSON boolean cannot be converted to type string");
-	case JSON_NUMBER: return json_fmt("%.15g", ((JSONNumber*)p)->value());
-	case JSON_STRING: return ((JSONString*)p)->value();
+	case JSON_NUMBER: return json_encode(as<JSONNumber>());
+	case JSON_STRING: return ((JSONString*)node())->value();
 	case JSON_ARRAY: throw json_type_error("JSON array cannot be converted to type string");
 	case JSON_OBJECT: default: throw json_type_error("JSON object cannot be converted to type string");
 	}
 }
 
 
+//
+// json_members
+//
+inline void json_members::grow(size_t size) {
+	value_type *q = a.allocate(size);
+	size_t i = 0;
+	try {
+		for (; i < n ; ++i)
+			new (q+i) value_type(p[i].first, JSON());
+	} catch (...) {
+		while (i) q[--i].~value_type();
+		a.deallocate(q, size);
+		throw;
+	}
+	for (i = 0 ; i < n ; ++i) {
+		q[i].second = std::move(p[i].second);
+		p[i].~value_type();
+	}
+	if (p) a.deallocate(p, c);
+	p = q;
+	c = size;
+}
+inline void json_members::keys(const value_type *f, const value_type *l, std::string *out) {
+	for (; f!=l ; ++f, ++out)
+		*out = f->first;
+}
+inline void json_members::append(const json_members& x) {
+	reserve(n + x.n);
+	for (size_t i = 0 ; i < x.n ; ++i, ++n)
+		new (p+n) value_type(x.p[i]);
+}
+inline json_members::value_type& json_members::insert(size_t i, std::string&& k, JSON&& v) {
+	enum { LOCAL=8 };
+	if (n==c) grow(c ? 2*c : 4);
+	if (i==n) {
+		new (p+n) value_type(std::move(k), std::move(v));
+		return p[n++];
+	}
+	std::string local[LOCAL];
+	std::vector<std::string> more(n-i > LOCAL ? n-i : 0);
+	std::string *moved = n-i > LOCAL ? more.data() : local;
+	keys(p+i, p+n, moved);
+	for (size_t j = n ; j > i ; --j) {  // nothing from here on throws
+		if (j < n) p[j].~value_type();
+		new (p+j) value_type(std::move(moved[j-1-i]), std::move(p[j-1].second));
+	}
+	if (i < n) p[i].~value_type();
+	new (p+i) value_type(std::move(k), std::move(v));
+	++n;
+	return p[i];
+}
+inline void json_members::erase(size_t f, size_t l) {
+	enum { LOCAL=8 };
+	if (f==l) return;
+	std::string local[LOCAL];
+	std::vector<std::string> more(n-l > LOCAL ? n-l : 0);
+	std::string *moved = n-l > LOCAL ? more.data() : local;
+	keys(p+l, p+n, moved);
+	for (size_t j = f ; j < l ; ++j)  // nothing from here on throws
+		p[j].~value_type();
+	for (size_t j = l ; j < n ; ++j) {
+		new (p+f+j-l) value_type(std::move(moved[j-l]), std::move(p[j].second));
+		p[j].~value_type();
+	}
+	n -= l-f;
+}
+
+
+//
+// JSONOrderedMap
+//
+inline uint32_t JSONOrderedMap::hash(const char *s, size_t n) {  // FNV-1a
+	uint32_t h = 2166136261u;
+	for (size_t i = 0 ; i < n ; ++i)
+		h = (h ^ (unsigned char)s[i]) * 16777619u;
+	return h;
+}
+inline size_t JSONOrderedMap::index(const char *s, size_t n, size_t& slot) const {
+	// index of the member with key @s, or -1; @slot is the index slot where it is, or would go
+	if (t.empty()) {
+		for (size_t i = first ; i < v.size() ; ++i) {
+			const std::string& k = v[i].first;
+			if (k.size()==n && memcmp(k.data(), s, n)==0 && !erased(i)) return i;
+		}
+		return (size_t)-1;
+	}
+	uint32_t h = hash(s,n);
+	size_t mask = t.size()-1;
+	for (slot = h & mask ;; slot = (slot+1) & mask) {
+		const Slot& x = t[slot];
+		if (!x.i) return (size_t)-1;
+		if (x.h==h) {  // the slots of erased members stay, until the next rehash
+			const std::string& k = v[x.i-1].first;
+			if (k.size()==n && memcmp(k.data(), s, n)==0 && !erased(x.i-1)) return x.i-1;
+		}
+	}
+}
+inline void JSONOrderedMap::rehash(size_t size) {
+	Slot empty = { 0, 0 };
+	t.assign(size, empty);
+	if (!size) return;
+	size_t mask = size-1;
+	for (size_t i = first ; i < v.size() ; ++i) {
+		if (erased(i)) continue;
+		uint32_t h = hash(v[i].first.data(), v[i].first.size());
+		size_t j = h & mask;
+		while (t[j].i) j = (j+1) & mask;
+		t[j].i = i+1;
+		t[j].h = h;
+	}
+}
+inline void JSONOrderedMap::compact() {
+	// drop the erased members, into an array with room for as many again as are left
+	json_members w(v.get_allocator());
+	w.reserve(size() > 2 ? 2*size() : 4);
+	for (size_t i = first ; i < v.size() ; ++i)
+		if (!erased(i)) w.insert(w.size(), std::string(v[i].first), JSON());
+	for (size_t i = first, j = 0 ; i < v.size() ; ++i)
+		if (!erased(i)) w[j++].second = std::move(v[i].second);
+	v.swap(w);
+	e.clear();
+	dead = first = 0;
+	rehash(v.size()>SMALL ? t.size() : 0);
+}
+inline std::pair<JSONOrderedMap::iterator,bool> JSONOrderedMap::add(entry&& x) {
+	size_t slot, i = index(x.first.data(), x.first.size(), slot);
+	if (i!=(size_t)-1)
+		return std::pair<iterator,bool>(iterator(this, i), false);
+
+	if (dead==v.size()) {
+		clear();
+	} else if (dead && v.size()==v.capacity()) {
+		compact();
+		index(x.first.data(), x.first.size(), slot);
+	}
+	const std::string& k = v.insert(v.size(), std::move(x.first), std::move(x.second)).first;
+	if (v.size()<=SMALL) {
+	} else if (2*v.size() > t.size()) {
+		rehash(t.empty() ? 4*SMALL : 2*t.size());
+	} else {
+		t[slot].i = v.size();
+		t[slot].h = hash(k.data(), k.size());
+	}
+	return std::pair<iterator,bool>(iterator(this, v.size()-1), true);
+}
+inline void JSONOrderedMap::erase(iterator pos) {
+	size_t i = pos.i;
+	if (e.size() <= i) e.resize(v.size());
+	v[i].second = JSON();  // the key stays until compact()
+	e[i] = true;
+	++dead;
+	while (first < v.size() && erased(first)) ++first;
+}
+inline bool operator==(const JSON& a, const JSON& b);
+inline bool operator<(const JSON& a, const JSON& b);
+inline bool JSONOrderedMap::operator==(const JSONOrderedMap& x) const {
+	if (size()!=x.size()) return false;
+	for (const_iterator i = begin() ; i!=end() ; ++i) {
+		const_iterator j = x.find(i->first);
+		if (j==x.end() || !(j->second==i->second)) return false;
+	}
+	return true;
+}
+inline void JSONOrderedMap::sorted(std::vector<const value_type*>& out) const {  // members by key
+	out.reserve(size());
+	for (const_iterator i = begin() ; i!=end() ; ++i)
+		out.push_back(&*i);
+	std::sort(out.begin(), out.end(), less);
+}
+inline bool JSONOrderedMap::operator<(const JSONOrderedMap& x) const {
+	std::vector<const value_type*> a, b;
+	sorted(a);
+	x.sorted(b);
+	return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(), less);
+}
+
+
+//
+// JSONSmallMap
+//
+inline size_t JSONSmallMap::position(const key_type& k) const {  // of the first flat member not less than @k
+	size_t j = 0;
+	while (j < n && slot(o[j]).first.compare(k) < 0)
+		++j;
+	return j;
+}
+template <class... Args>
+inline unsigned char JSONSmallMap::place(size_t j, Args&&... args) {  // a new flat member, at position @j in key order
+	unsigned k = 0;
+	while (used & 1u<<k) ++k;
+	if (!b[k/HALF]) b[k/HALF] = a.allocate(HALF);
+	new (&slot(k)) value_type(std::forward<Args>(args)...);
+	memmove(o+j+1, o+j, n-j);
+	o[j] = k;
+	++n;
+	used |= 1u<<k;
+	return k;
+}
+inline void JSONSmallMap::remove(unsigned k) {  // the other flat members stay where they are
+	size_t j = order(k);
+	slot(k).~value_type();
+	memmove(o+j, o+j+1, n-j-1);
+	--n;
+	used &= ~(1u<<k);
+}
+inline void JSONSmallMap::assign(const JSONSmallMap& x) {  // this map must be empty
+	if (x.tree) {
+		m = x.m;
+		tree = true;
+	} else {
+		for (size_t j = 0 ; j < x.n ; ++j)
+			place(j, x.slot(x.o[j]));
+	}
+}
+inline void JSONSmallMap::promote() {  // the keys are copied into the tree before the values move
+	tree_type x(m.key_comp(), m.get_allocator());
+	for (size_t j = 0 ; j < n ; ++j)
+		x.emplace_hint(x.end(), slot(o[j]).first, JSON());
+	tree_type::iterator i = x.begin();
+	for (size_t j = 0 ; j < n ; ++j, ++i)
+		i->second = std::move(slot(o[j]).second);
+	m.swap(x);
+	for (size_t j = 0 ; j < n ; ++j)
+		slot(o[j]).~value_type();
+	n = 0;
+	used = 0;
+	for (int j = 0 ; j < 2 ; ++j) {
+		if (b[j]) a.deallocate(b[j], HALF);
+		b[j] = 0;
+	}
+	tree = true;
+}
+inline std::pair<JSONSmallMap::iterator,bool> JSONSmallMap::add(entry&& x) {
+	if (!tree) {
+		size_t j = position(x.first);
+		if (j<n && slot(o[j]).first==x.first)
+			return std::pair<iterator,bool>(iterator(this, o[j]), false);
+		if (n < SMALL)
+			return std::pair<iterator,bool>(iterator(this, place(j, std::move(x.first), std::move(x.second))), true);
+		promote();
+	}
+	std::pair<tree_type::iterator,bool> p = m.insert(std::move(x));
+	return std::pair<iterator,bool>(iterator(p.first), p.second);
+}
+
+
 //
 // JSONObject
 //
@@ -736,14 +1922,21 @@ inline bool operator==(const JSON& a, const JSON& b) {
 		switch (a.type()) {
 		case JSON_NULL: return true;
 		case JSON_BOOLEAN: return ((JSONBool*)a.get())->value() == ((JSONBool*)b.get())->value();
-		case JSON_NUMBER: return ((JSONNumber*)a.get())->value() == ((JSONNumber*)b.get())->value();
-		case JSON_STRING: return ((JSONString*)a.get())->value() == ((JSONString*)b.get())->value();
+		case JSON_NUMBER: {
+			const JSONNumber& x = *(JSONNumber*)a.get();
+			const JSONNumber& y = *(JSONNumber*)b.get();
+			return x.integer() && y.integer() ? x.int64() == y.int64() : x.value() == y.value();
+			}
+		case JSON_STRING: {
+			const JSONString& x = *(JSONString*)a.get();
+			const JSONString& y = *(JSONString*)b.get();
+			return x.size()==y.size() && memcmp(x.data(), y.data(), x.size())==0;
+			}
 		case JSON_ARRAY: return (*(JSONArray*)a.get()) == (*(JSONArray*)b.get());
 		case JSON_OBJECT: return (*(JSONObject*)a.get()) == (*(JSONObject*)b.get());
 		}
-	} else {
-		return false;
 	}
+	return false;
 }
 
 inline bool operator!=(const JSON& a, bool b) {
@@ -779,7 +1972,11 @@ inline bool operator<(const JSON& a, const JSON& b) {
 		switch (a.type()) {
 		case JSON_NULL: return false;
 		case JSON_BOOLEAN: return ((JSONBool*)a.get())->value() < ((JSONBool*)b.get())->value();
-		case JSON_NUMBER: return ((JSONNumber*)a.get())->value() < ((JSONNumber*)b.get())->value();
+		case JSON_NUMBER: {
+			const JSONNumber& x = *(JSONNumber*)a.get();
+			const JSONNumber& y = *(JSONNumber*)b.get();
+			return x.integer() && y.integer() ? x.int64() < y.int64() : x.value() < y.value();
+			}
 		case JSON_STRING: return ((JSONString*)a.get())->value() < ((JSONString*)b.get())->value();
 		case JSON_ARRAY: return (*(JSONArray*)a.get()) < (*(JSONArray*)b.get());
 		case JSON_OBJECT: return (*(JSONObject*)a.get()) < (*(JSONObject*)b.get());
@@ -805,4 +2002,456 @@ inline bool operator<(const JSONObject& a, const JSONObject& b) {
 	return a.operator<(b);
 }
 
+
+//
+// json_parse(): the decoder itself, with json_decode() as one of its handlers;
+// the structural index and the tokens are read by functions in stajson.cc
+//
+struct json_masks {  // one bit per character of a 64-byte block
+	uint64_t quote;      // "
+	uint64_t backslash;  // \ (backslash)
+	uint64_t op;         // {}[]:,
+	uint64_t space;      // space, tab, CR, LF
+};
+typedef void (*json_classifier)(const char *p, json_masks& m);
+
+class json_scanner {  // state carried from one block to the next
+	uint64_t escaped;    // 1 if the first character of the next block is escaped
+	uint64_t in_string;  // all ones if the next block starts inside a string
+	uint64_t token;      // 1 if the last character was part of a token other than a string
+public:
+	json_scanner() : escaped(0), in_string(0), token(0) { }
+	inline uint64_t structurals(const json_masks& m);
+};
+
+class json_index {  // reads the structural positions of an input in order
+	enum { WINDOW=32768 };  // bytes indexed at a time, so that stage 2 finds them in cache
+	enum { SMALL=256 };  // inputs up to this long are indexed into the object itself
+
+	const char *s;
+	size_t n;
+	size_t indexed;  // how much of the input is indexed
+	json_classifier classify;
+	json_scanner scanner;
+	uint32_t *v;  // positions in the current window
+	uint32_t small[SMALL];
+	size_t base;  // start of the current window
+	size_t k, size;
+
+	void fill();
+
+	json_index(const json_index&);
+	json_index& operator=(const json_index&);
+public:
+	json_index(const char *s, size_t n, size_t from=0);  // of @s, from @from on
+	inline ~json_index() { if (v!=small) delete[] v; }
+
+	inline bool done() {
+		while (k==size) {
+			if (indexed==n) return true;
+			fill();
+		}
+		return false;
+	}
+	inline size_t peek() const { return base + v[k]; }  // only if !done()
+	inline size_t next() { return base + v[k++]; }  // only if !done()
+};
+
+inline bool json_delimiter(const char *p, const char *end) {  // whether a token may end before @p
+	if (p==end) return true;
+	switch (*p) {
+	case ' ': case '\t': case '\r': case '\n':
+	case '{': case '}': case '[': case ']': case ':': case ',':
+		return true;
+	default:
+		return false;
+	}
+}
+class json_value_end {  // finds where the first value of a stream ends, a buffer at a time
+	enum { CONTAINER, NUMBER, LITERAL } kind;
+	size_t depth;  // CONTAINER: open arrays and objects
+	bool in_string, escaped;
+	int state;  // NUMBER: where it is in the number, 3 before the first character; LITERAL: characters left
+public:
+	json_value_end() : kind(CONTAINER), depth(0), in_string(false), escaped(false), state(0) { }
+	inline void start(char c);
+	inline const char *scan(const char *p, const char *e);
+};
+
+const char *json_scan_number(const char *s, const char *p, const char *end, size_t base=0);
+JSONNumber json_parse_number(const char *p, const char *end);
+const char *json_scan_string(const char *s, const char *p, const char *end, std::string& buf, const char *&str, size_t& n, size_t base=0);
+const char *json_read_value(std::istream& in, std::string& buf, size_t& n);
+
+template <class Handler, class Index>
+const char *json_parse_value(const char *s, size_t n, Index& i, Handler& h) {
+	// parses the value at the next position of @i, a json_index or anything
+	// with its done(), peek() and next(), and returns its end
+	const char *end = s+n;
+	std::vector<bool> stack;  // open arrays and objects, true for an object
+	std::string buf;  // strings with escapes
+	const char *p, *str, *last;  // @last: the end of the last token
+	size_t len;
+
+value:
+	if (i.done())
+		throw std::runtime_error(json_fmt("%d: JSON invalid end of input",(int)n));
+	p = s + i.next();
+	switch (*p) {
+	case '[':
+		if (json_max_depth && stack.size() >= json_max_depth)
+			throw std::runtime_error(json_fmt("%d: JSON nesting too deep",(int)(p-s)));
+		h.start_array();
+		if (!i.done() && s[i.peek()]==']') {
+			last = s + i.next() + 1;
+			h.end_array();
+			goto after_value;
+		}
+		stack.push_back(false);
+		goto value;
+	case '{':
+		if (json_max_depth && stack.size() >= json_max_depth)
+			throw std::runtime_error(json_fmt("%d: JSON nesting too deep",(int)(p-s)));
+		h.start_object();
+		if (!i.done() && s[i.peek()]=='}') {
+			last = s + i.next() + 1;
+			h.end_object();
+			goto after_value;
+		}
+		stack.push_back(true);
+		if (i.done())
+			throw std::runtime_error(json_fmt("%d: JSON invalid end of input",(int)n));
+		if (s[i.peek()]!='"')
+			throw std::runtime_error(json_fmt("%d: JSON syntax error: expected '}' or '\"' after object start",(int)i.peek()));
+		goto key;
+	case 'n':
+		if (end-p<4 || strncmp(p,"null",4)!=0 || !json_delimiter(p+4,end))
+			throw std::runtime_error(json_fmt("%d: JSON syntax error: expected \"null\"",(int)(p-s)));
+		h.null();
+		last = p+4;
+		break;
+	case 'f':
+		if (end-p<5 || strncmp(p,"false",5)!=0 || !json_delimiter(p+5,end))
+			throw std::runtime_error(json_fmt("%d: JSON syntax error: expected \"false\"",(int)(p-s)));
+		h.boolean(false);
+		last = p+5;
+		break;
+	case 't':
+		if (end-p<4 || strncmp(p,"true",4)!=0 || !json_delimiter(p+4,end))
+			throw std::runtime_error(json_fmt("%d: JSON syntax error: expected \"true\"",(int)(p-s)));
+		h.boolean(true);
+		last = p+4;
+		break;
+	case '-':
+	case '0': case '1': case '2': case '3': case '4':
+	case '5': case '6': case '7': case '8': case '9': {
+		const char *q = json_scan_number(s, p, end);
+		if (!json_delimiter(q,end))
+			throw std::runtime_error(json_fmt("%d: JSON syntax error: unexpected character after number",(int)(q-s)));
+		h.number(json_parse_number(p, q));
+		last = q;
+		} break;
+	case '"':
+		last = json_scan_string(s, p, end, buf, str, len);
+		h.string(str, len);
+		break;
+	default:
+		throw std::runtime_error(json_fmt("%d: JSON syntax error: invalid token",(int)(p-s)));
+	}
+
+after_value:
+	if (stack.empty())
+		return last;
+	if (i.done())
+		throw std::runtime_error(json_fmt("%d: JSON invalid end of input",(int)n));
+	p = s + i.next();
+	if (!stack.back()) {
+		switch (*p) {
+		case ',':
+			goto value;
+		case ']':
+			stack.pop_back();
+			last = p+1;
+			h.end_array();
+			goto after_value;
+		default:
+			throw std::runtime_error(json_fmt("%d: JSON syntax error: expected ',' or ']' after array element",(int)(p-s)));
+		}
+	}
+	switch (*p) {
+	case ',':
+		if (i.done())
+			throw std::runtime_error(json_fmt("%d: JSON invalid end of input",(int)n));
+		if (s[i.peek()]!='"')
+			throw std::runtime_error(json_fmt("%d: JSON syntax error: expected '\"' after comma in object",(int)i.peek()));
+		goto key;
+	case '}':
+		stack.pop_back();
+		last = p+1;
+		h.end_object();
+		goto after_value;
+	default:
+		throw std::runtime_error(json_fmt("%d: JSON syntax error: expected ',' or '}' after object key-value pair",(int)(p-s)));
+	}
+
+key:  // the next position is the opening quotes of a key
+	p = json_scan_string(s, s + i.next(), end, buf, str, len);
+	if (i.done())
+		throw std::runtime_error(json_fmt("%d: JSON invalid end of input",(int)n));
+	if (s[i.peek()]!=':' || (size_t)(p-s) > i.peek())
+		throw std::runtime_error(json_fmt("%d: JSON syntax error: expected ':' after object key",(int)(p-s)));
+	i.next();
+	h.key(str, len);
+	goto value;
+}
+
+template <class Handler>
+void json_parse(const char *s, size_t n, Handler& h) {
+	json_index i(s, n);
+	json_parse_value(s, n, i, h);
+	if (!i.done())
+		throw std::runtime_error(json_fmt("%d: JSON syntax error",(int)i.peek()));
+}
+
+template <class Handler>
+void json_parse(std::istream& in, Handler& h) {
+	// the value is parsed in the stream buffer, or in a copy of it when it
+	// does not end in there; @h must not read from @in meanwhile
+	std::string buf;
+	size_t n;
+	const char *s = json_read_value(in, buf, n);
+	json_parse(s, n, h);
+}
+
+
+//
+// JSONReader: a pull parser over the same structural index as json_parse();
+// next() reads the input one token at a time, and nothing is built unless
+// value() is asked for, so a huge array can be walked an element at a time
+//
+class JSONReader {
+public:
+	enum Token {
+		END,  // before the first token, and after the last
+		NULL_VALUE,
+		BOOLEAN,
+		NUMBER,
+		STRING,
+		KEY,  // of an object member; its value is the next token
+		ARRAY_START,
+		ARRAY_END,
+		OBJECT_START,
+		OBJECT_END
+	};
+private:
+	const char *s;
+	size_t n;
+	json_index i;
+	std::vector<bool> stack;  // open arrays and objects, true for an object
+	enum { VALUE, AFTER_VALUE, KEY_NEXT, CLOSE, DONE } state;  // what the next token is
+	Token t;
+	const char *p;  // the current token
+	bool b;  // BOOLEAN
+	JSONNumber num;  // NUMBER
+	const char *str;  // STRING, KEY: in the input, or in @buf if it had escapes
+	size_t len;
+	std::string buf;
+
+	JSONReader(const JSONReader&);
+	JSONReader& operator=(const JSONReader&);
+public:
+	// the input must not change or go away while it is read
+	JSONReader(const char *s, size_t n);
+	JSONReader(const std::string& in);
+
+	Token next();
+	void skip();  // of an ARRAY_START, OBJECT_START or KEY, past the whole value
+	void value(JSON& out);  // the current value as a tree, then as skip()
+	inline JSON value() { JSON out; value(out); return out; }
+
+	inline Token token() const { return t; }
+	inline size_t depth() const { return stack.size(); }  // of the arrays and objects open
+	inline size_t offset() const { return p ? p-s : 0; }  // of the current token in the input
+
+	inline bool boolean() const {
+		if (t!=BOOLEAN) throw json_type_error("not a JSON boolean");
+		return b;
+	}
+	inline const JSONNumber& number() const {
+		if (t!=NUMBER) throw json_type_error("not a JSON number");
+		return num;
+	}
+	// the characters of a STRING or KEY, only valid until next()
+	inline const char *data() const {
+		if (t!=STRING && t!=KEY) throw json_type_error("not a JSON string");
+		return str;
+	}
+	inline size_t size() const {
+		if (t!=STRING && t!=KEY) throw json_type_error("not a JSON string");
+		return len;
+	}
+	inline std::string string() const { return std::string(data(), size()); }
+};
+
+
+//
+// JSONPushParser: decodes a series of values from input that arrives in
+// pieces, such as reads from a non-blocking socket; a value that ends in the
+// piece it starts in is decoded straight from there, and one that goes on
+// past it is built as its pieces arrive, keeping only its open arrays and
+// objects and the characters of a token cut between pieces
+//
+class json_push_parser;
+class JSONPushParser {
+	json_push_parser *p;
+	std::deque<JSON> values;  // decoded, not yet taken
+
+	JSONPushParser(const JSONPushParser&);
+	JSONPushParser& operator=(const JSONPushParser&);
+public:
+	JSONPushParser();
+	~JSONPushParser();
+
+	// values may be separated by whitespace or nothing at all; a syntax error
+	// is thrown after the values before it are ready, and leaves the parser
+	// to be cleared
+	void feed(const char *s, size_t n);
+	inline void feed(const std::string& s) { feed(s.data(),s.size()); }
+	void finish();  // at the end of the input, for a number that ends it
+
+	inline size_t ready() const { return values.size(); }
+	inline bool next(JSON& out) {  // takes the first value decoded, if there is one
+		if (values.empty()) return false;
+		out = std::move(values.front());
+		values.pop_front();
+		return true;
+	}
+	void clear();
+};
+
+
+//
+// JSONParallelDecoder: decodes a series of values, such as the lines of a
+// JSON Lines file, on several threads; next() gives them back in input order
+//
+class json_batch;
+class JSONParallelDecoder {
+	json_batch *b;
+
+	JSONParallelDecoder(const JSONParallelDecoder&);
+	JSONParallelDecoder& operator=(const JSONParallelDecoder&);
+public:
+	// values may be separated by whitespace or nothing at all, but the input
+	// is cut for the threads after newlines, so it goes fastest with values
+	// that do not span lines; @threads is 0 for one per processor; the input
+	// must not change or go away until the decoder is destroyed
+	JSONParallelDecoder(const char *s, size_t n, unsigned threads=0);
+	JSONParallelDecoder(const std::string& in, unsigned threads=0);
+	~JSONParallelDecoder();
+
+	// the next value, or false after the last; for a value with a syntax
+	// error, the error is thrown instead, and the next call goes on after it
+	bool next(JSON& out);
+};
+
+// decodes a top-level array on several threads, each with a share of its
+// elements, which the structural index hands out as it finds them; anything
+// other than an array, or too small to share, is decoded as by json_decode()
+void json_decode_parallel(const char *s, size_t n, JSON& out, unsigned threads=0);
+inline void json_decode_parallel(const std::string& in, JSON& out, unsigned threads=0) { json_decode_parallel(in.data(),in.size(),out,threads); }
+inline void json_decode_parallel(const char *in, JSON& out, unsigned threads=0) { json_decode_parallel(in,strlen(in),out,threads); }
+#if __cplusplus >= 201703L
+inline void json_decode_parallel(std::string_view in, JSON& out, unsigned threads=0) { json_decode_parallel(in.data(),in.size(),out,threads); }
+#endif
+void json_decode_file_parallel(const char *path, JSON& out, unsigned threads=0);  // json_decode_parallel() on a mapped file
+
+
+//
+// JSONLazyDocument: the input is checked and indexed once, and then read
+// through JSONLazy values, which look like const JSON values but decode only
+// what is asked of them; the input must not change or go away meanwhile
+//
+class JSONLazy;
+class JSONLazyDocument {
+	friend class JSONLazy;
+	friend class json_lazy_index;
+
+	struct token {  // a value, key or closing bracket
+		uint32_t pos;
+		uint32_t after;  // the token after the value that starts here
+	};
+
+	const char *s;
+	size_t n;
+	std::vector<token> t;  // in input order, without the commas and colons
+
+	JSONLazyDocument(const JSONLazyDocument&);
+	JSONLazyDocument& operator=(const JSONLazyDocument&);
+public:
+	JSONLazyDocument(const char *s, size_t n);  // throws as json_decode() would, or if @n is 4 GB or more
+	JSONLazyDocument(const std::string& in);
+
+	inline JSONLazy root() const;
+};
+
+class JSONLazy {
+	const JSONLazyDocument *d;
+	size_t k;  // the first token of the value
+	mutable size_t ci, ck;  // the element element() reached last, and its token, or 0; not for two threads at once
+
+	inline char c() const { return d->s[d->t[k].pos]; }
+	size_t find(const char *key, size_t len) const;  // the value of the last member @key, or 0
+	size_t element(size_t i) const;  // or 0; goes on from the element reached last, if it is not past @i
+	inline JSONLazy at(size_t k) const { return JSONLazy(d, k); }
+public:
+	inline JSONLazy(const JSONLazyDocument *d, size_t k) : d(d), k(k), ci(0), ck(0) { }
+
+	class iterator {  // over the elements of an array, or the members of an object as they are in the input
+		friend class JSONLazy;
+		const JSONLazyDocument *d;
+		size_t k;  // the element, or the key of the member
+		bool object;
+		inline iterator(const JSONLazyDocument *d, size_t k, bool object) : d(d), k(k), object(object) { }
+	public:
+		inline JSONLazy operator*() const { return JSONLazy(d, object ? k+1 : k); }
+		inline JSONLazy value() const { return **this; }
+		inline std::string key() const { return JSONLazy(d, k).string(); }  // objects only
+		inline iterator& operator++() { k = d->t[object ? k+1 : k].after; return *this; }
+		inline bool operator==(const iterator& x) const { return k==x.k; }
+		inline bool operator!=(const iterator& x) const { return k!=x.k; }
+	};
+
+	JSONType type() const;
+	size_t size() const;  // of an array or object, counting each repeated key of an object
+	iterator begin() const;
+	iterator end() const;
+
+	inline bool has(int i) const { return i >= 0 && has((size_t)i); }
+	inline bool has(size_t i) const { return element(i)!=0; }
+	inline bool has(const char *s) const { return find(s,strlen(s))!=0; }
+	inline bool has(const std::string& s) const { return find(s.data(),s.size())!=0; }
+
+	inline JSONLazy get(int i) const { return get((size_t)i); }
+	JSONLazy get(size_t i) const;
+	inline JSONLazy get(const char *s) const { return get(std::string(s)); }
+	JSONLazy get(const std::string& s) const;
+	inline JSONLazy operator[](int i) const { return get(i); }
+	inline JSONLazy operator[](size_t i) const { return get(i); }
+	inline JSONLazy operator[](const char *s) const { return get(s); }
+	inline JSONLazy operator[](const std::string& s) const { return get(s); }
+
+	bool boolean() const;
+	JSONNumber number() const;
+	std::string string() const;
+	JSON decode() const;  // the value and everything in it, as an ordinary JSON value
+
+	operator bool() const;
+	operator double() const;
+	operator std::string() const;
+};
+
+inline JSONLazy JSONLazyDocument::root() const {
+	return JSONLazy(this, 0);
+}
+
 #endif